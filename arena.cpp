@@ -0,0 +1,290 @@
+#include "arena.h"
+#include "sim.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint32_t MAP_MAGIC   = 0x4d4e5254; // "TRNM"
+constexpr uint32_t MAP_VERSION = 1;
+constexpr int      MAP_MAX     = 4096;       // per side
+constexpr int      MAX_SPAWNS  = 32;
+
+struct Header {
+    uint32_t magic, version;
+    uint16_t w, h;
+    uint32_t nspawns;
+};
+}
+
+using Arena::Map;
+using Arena::Spawn;
+
+Map::~Map() { Arena::release(*this); }
+
+void Arena::release(Map& m) {
+    if (m.mapping) munmap(m.mapping, m.map_len);
+    m.mapping = nullptr; m.map_len = 0;
+    m.own_cells.clear(); m.own_spawns.clear();
+    m.cells = nullptr; m.spawns = nullptr;
+    m.w = m.h = m.nspawns = 0;
+}
+
+bool Arena::load(Map& m, const std::string& path) {
+    release(m);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    void* p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Header))
+        p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+    m.mapping = p; m.map_len = st.st_size;
+
+    const Header* h = (const Header*)p;
+    if (h->magic != MAP_MAGIC || h->version != MAP_VERSION ||
+        h->w < 16 || h->h < 12 || h->w > MAP_MAX || h->h > MAP_MAX ||
+        h->nspawns > MAX_SPAWNS * 8 ||
+        m.map_len != sizeof(Header) + h->nspawns*sizeof(Spawn) + (size_t)h->w*h->h) {
+        release(m);
+        return false;
+    }
+    m.w = h->w; m.h = h->h;
+    m.spawns = (const Spawn*)((const char*)p + sizeof(Header));
+    m.nspawns = h->nspawns;
+    m.cells = (const Cell*)(m.spawns + m.nspawns);
+
+    // the sim indexes players by cell value, so only walls may come from disk
+    for (int i=0; i<m.w*m.h; i++)
+        if (m.cells[i] > C_WALL) { release(m); return false; }
+    // a spawn's cell and first step must be open, or the bike is placed over a wall
+    for (int i=0; i<m.nspawns; i++) {
+        const Spawn& s = m.spawns[i];
+        if (s.x < 1 || s.x >= m.w-1 || s.y < 1 || s.y >= m.h-1 || s.dir >= D_NONE ||
+            m.cells[s.y*m.w + s.x] != C_EMPTY ||
+            m.cells[(s.y+dir_dy((Dir)s.dir))*m.w + s.x+dir_dx((Dir)s.dir)] != C_EMPTY) {
+            release(m);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Arena::save(const Map& m, const std::string& path) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    Header h = {MAP_MAGIC, MAP_VERSION, (uint16_t)m.w, (uint16_t)m.h, (uint32_t)m.nspawns};
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(m.spawns, sizeof(Spawn), m.nspawns, f) == (size_t)m.nspawns &&
+              fwrite(m.cells, 1, (size_t)m.w*m.h, f) == (size_t)m.w*m.h;
+    return fclose(f) == 0 && ok;
+}
+
+// ---- generator ----
+
+namespace {
+struct Gen {
+    int W, H;
+    std::vector<Cell>& g;
+    Sim::Rng& rng;
+
+    Cell& at(int x, int y) { return g[y*W + x]; }
+    bool  inside(int x, int y) const { return x>0 && x<W-1 && y>0 && y<H-1; }
+    void  hwall(int x0, int x1, int y) { for (int x=x0; x<=x1; x++) at(x,y) = C_WALL; }
+    void  vwall(int x, int y0, int y1) { for (int y=y0; y<=y1; y++) at(x,y) = C_WALL; }
+    void  clear(int x0, int y0, int x1, int y1) {
+        for (int y=y0; y<=y1; y++)
+            for (int x=x0; x<=x1; x++)
+                if (inside(x,y)) at(x,y) = C_EMPTY;
+    }
+    bool  empty(int x0, int y0, int x1, int y1) {
+        for (int y=y0; y<=y1; y++)
+            for (int x=x0; x<=x1; x++)
+                if (!inside(x,y) || at(x,y) != C_EMPTY) return false;
+        return true;
+    }
+};
+
+// braided maze on a coarse lattice: terminal cells are ~2:1, so corridors
+// are twice as wide as they are tall
+void gen_maze(Gen& G) {
+    constexpr int SX = 12, SY = 6;
+    int cols = (G.W-1) / SX, rows = (G.H-1) / SY;
+    if (cols < 2 || rows < 2) return;
+    // open[c] bit 0 = right wall removed, bit 1 = bottom wall removed
+    std::vector<uint8_t> open(cols*rows, 0), seen(cols*rows, 0);
+    std::vector<int> stack = {0};
+    seen[0] = 1;
+    while (!stack.empty()) {
+        int c = stack.back(), cx = c % cols, cy = c / cols;
+        int nb[4], n = 0;
+        if (cx > 0      && !seen[c-1])    nb[n++] = c-1;
+        if (cx < cols-1 && !seen[c+1])    nb[n++] = c+1;
+        if (cy > 0      && !seen[c-cols]) nb[n++] = c-cols;
+        if (cy < rows-1 && !seen[c+cols]) nb[n++] = c+cols;
+        if (!n) { stack.pop_back(); continue; }
+        int d = nb[G.rng(n)];
+        if (d == c+1)         open[c]    |= 1;
+        else if (d == c-1)    open[d]    |= 1;
+        else if (d == c+cols) open[c]    |= 2;
+        else                  open[d]    |= 2;
+        seen[d] = 1;
+        stack.push_back(d);
+    }
+    // knock out extra walls so there are loops to drive around
+    for (auto& o : open) {
+        if (G.rng(100) < 30) o |= 1;
+        if (G.rng(100) < 30) o |= 2;
+    }
+    for (int cy=0; cy<rows; cy++)
+        for (int cx=0; cx<cols; cx++) {
+            uint8_t o = open[cy*cols + cx];
+            int x = (cx+1)*SX, y = (cy+1)*SY;
+            if (cx < cols-1 && !(o & 1)) G.vwall(x, cy*SY, y);
+            if (cy < rows-1 && !(o & 2)) G.hwall(cx*SX, x, y);
+        }
+}
+
+// recursive division: split the room with a wall, cut doors, recurse.
+// doors are carved after everything else so a later wall can't plug them.
+struct Door { int x0, y0, x1, y1; };
+void divide(Gen& G, int x0, int y0, int x1, int y1, std::vector<Door>& doors) {
+    constexpr int MINW = 24, MINH = 10;
+    int w = x1 - x0, h = y1 - y0;
+    bool can_v = w >= 2*MINW, can_h = h >= 2*MINH;
+    if (!can_v && !can_h) return;
+    bool vert = can_v && (!can_h || w >= 2*h); // rooms look square at w = 2h
+    if (vert) {
+        int x = x0 + MINW + G.rng(w - 2*MINW + 1);
+        G.vwall(x, y0, y1);
+        int nd = 1 + (h > 20);
+        for (int i=0; i<nd; i++) {
+            int dy = y0 + 1 + G.rng(std::max(1, h - 4));
+            doors.push_back({x, dy, x, dy+2});
+        }
+        divide(G, x0, y0, x, y1, doors);
+        divide(G, x, y0, x1, y1, doors);
+    } else {
+        int y = y0 + MINH + G.rng(h - 2*MINH + 1);
+        G.hwall(x0, x1, y);
+        int nd = 1 + (w > 40);
+        for (int i=0; i<nd; i++) {
+            int dx = x0 + 1 + G.rng(std::max(1, w - 8));
+            doors.push_back({dx, y, dx+5, y});
+        }
+        divide(G, x0, y0, x1, y, doors);
+        divide(G, x0, y, x1, y1, doors);
+    }
+}
+
+void gen_rooms(Gen& G) {
+    std::vector<Door> doors;
+    divide(G, 0, 0, G.W-1, G.H-1, doors);
+    for (auto& d : doors) G.clear(d.x0, d.y0, d.x1, d.y1);
+}
+
+// scattered crosses and bars with a clear margin around each
+void gen_pillars(Gen& G) {
+    int want = G.W * G.H / 350, budget = want * 20;
+    for (int tries=0; tries<budget && want>0; tries++) {
+        int x = 6 + G.rng(G.W-12), y = 4 + G.rng(G.H-8);
+        int kind = G.rng(3);
+        int ax = kind==1 ? 0 : 2 + G.rng(3);  // horizontal arm
+        int ay = kind==2 ? 0 : 1 + G.rng(2);  // vertical arm
+        if (kind == 0) { ax = 2; ay = 1; }
+        if (!G.empty(x-ax-3, y-ay-2, x+ax+3, y+ay+2)) continue;
+        if (ax) G.hwall(x-ax, x+ax, y);
+        if (ay) G.vwall(x, y-ay, y+ay);
+        want--;
+    }
+}
+
+// free cells straight ahead of (x,y) going d, up to cap
+int run_len(Gen& G, int x, int y, Dir d, int cap) {
+    int n = 0;
+    for (x+=dir_dx(d), y+=dir_dy(d); n<cap && G.inside(x,y) && G.at(x,y)==C_EMPTY;
+         x+=dir_dx(d), y+=dir_dy(d))
+        n++;
+    return n;
+}
+
+// candidate spots facing their longest straight, then farthest-point
+// sampling so the first N spawns are spread out for any N
+void gen_spawns(Gen& G, std::vector<Spawn>& out) {
+    std::vector<Spawn> cand;
+    for (int tries=0; tries<2000 && (int)cand.size()<600; tries++) {
+        int x = 3 + G.rng(G.W-6), y = 3 + G.rng(G.H-6);
+        if (G.at(x,y) != C_EMPTY) continue;
+        Dir best = D_RIGHT; int best_len = -1;
+        for (int d=0; d<4; d++) {
+            int l = run_len(G, x, y, (Dir)d, 30);
+            if (l > best_len) { best_len = l; best = (Dir)d; }
+        }
+        if (best_len < 8) continue;
+        cand.push_back({(uint16_t)x, (uint16_t)y, (uint8_t)best, 0});
+    }
+    out.clear();
+    if (cand.empty()) return;
+    std::vector<long> near(cand.size(), 1L<<40);
+    int pick = 0;
+    while ((int)out.size() < MAX_SPAWNS) {
+        const Spawn s = cand[pick];
+        out.push_back(s);
+        long far = -1;
+        for (size_t i=0; i<cand.size(); i++) {
+            long dx = cand[i].x - s.x, dy = 2*(cand[i].y - s.y);
+            long d = dx*dx + dy*dy;
+            if (d < near[i]) near[i] = d;
+            if (near[i] > far) { far = near[i]; pick = (int)i; }
+        }
+        if (far < 64) break; // everything left is on top of a spawn
+    }
+}
+}
+
+void Arena::generate(Map& m, Kind kind, int w, int h, uint32_t seed) {
+    release(m);
+    m.w = w; m.h = h;
+    m.own_cells.assign(w*h, C_EMPTY);
+    Sim::Rng rng;
+    rng.seed(seed);
+    Gen G{w, h, m.own_cells, rng};
+    G.hwall(0, w-1, 0); G.hwall(0, w-1, h-1);
+    G.vwall(0, 0, h-1); G.vwall(w-1, 0, h-1);
+    switch (kind) {
+        case MAZE:    gen_maze(G);    break;
+        case PILLARS: gen_pillars(G); break;
+        case ROOMS:   gen_rooms(G);   break;
+        default: break;
+    }
+    gen_spawns(G, m.own_spawns);
+    m.cells = m.own_cells.data();
+    m.spawns = m.own_spawns.data();
+    m.nspawns = (int)m.own_spawns.size();
+}
+
+int Arena::mapgen(int argc, char* argv[]) {
+    if (argc < 7) {
+        fprintf(stderr, "usage: %s mapgen <maze|pillars|rooms|open> <w> <h> <seed> <file>\n", argv[0]);
+        return 2;
+    }
+    int kind = -1;
+    for (int k=0; k<KIND_COUNT; k++)
+        if (strcasecmp(argv[2], kind_name[k]) == 0) kind = k;
+    int w = atoi(argv[3]), h = atoi(argv[4]);
+    if (kind < 0 || w < 16 || h < 12 || w > MAP_MAX || h > MAP_MAX) {
+        fprintf(stderr, "tron: bad map kind or size\n");
+        return 2;
+    }
+    Map m;
+    generate(m, (Kind)kind, w, h, (uint32_t)strtoul(argv[5], nullptr, 10));
+    if (!save(m, argv[6])) { perror(argv[6]); return 1; }
+    printf("%s: %dx%d %s, %d spawns\n", argv[6], w, h, kind_name[kind], m.nspawns);
+    return 0;
+}
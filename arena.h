@@ -0,0 +1,51 @@
+#pragma once
+#include "types.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// arena layouts: walls + a spawn table. either mmap'd from a map file or
+// generated from a seed. the cell block is byte-for-byte the Sim grid layout
+// (row-major Cell), so starting a round is one memcpy whatever the size.
+//
+// file format (native endian):
+//   Header { magic "TRNM", version, w, h, nspawns }
+//   Spawn  spawns[nspawns]
+//   Cell   cells[w*h]        C_EMPTY or C_WALL only
+namespace Arena {
+    enum Kind { OPEN=0, MAZE, PILLARS, ROOMS, KIND_COUNT };
+    constexpr const char* kind_name[] = {"Open","Maze","Pillars","Rooms"};
+
+    struct Spawn {
+        uint16_t x, y;
+        uint8_t  dir, pad; // Dir
+    };
+
+    struct Map {
+        int w = 0, h = 0;
+        const Cell*  cells  = nullptr;
+        const Spawn* spawns = nullptr; // spread out: any prefix is a fair seating
+        int nspawns = 0;
+
+        // backing store: a file mapping, or owned buffers for generated maps
+        void*  mapping = nullptr;
+        size_t map_len = 0;
+        std::vector<Cell>  own_cells;
+        std::vector<Spawn> own_spawns;
+
+        Map() = default;
+        Map(const Map&) = delete;
+        Map& operator=(const Map&) = delete;
+        ~Map();
+    };
+
+    // maps the file read-only; false (and an empty map) if it isn't a valid map
+    bool load(Map& m, const std::string& path);
+    bool save(const Map& m, const std::string& path);
+    // seeded layout for a w x h world; OPEN gives the plain box
+    void generate(Map& m, Kind kind, int w, int h, uint32_t seed);
+    void release(Map& m);
+
+    // ./tron mapgen <maze|pillars|rooms> <w> <h> <seed> <file>
+    int mapgen(int argc, char* argv[]);
+}
@@ -0,0 +1,217 @@
+#include "bench.h"
+#include "sim.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+// all-CPU (hard) rounds on a fixed-size arena, same seeds for both kernels,
+// a new round whenever one ends. prints ticks per second per mode.
+
+static double now_sec() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec/1e9;
+}
+
+static Sim::World w;
+
+static double ticks_per_sec(GameMode mode, Slot* slots, int n, bool generic, bool lod, long ticks) {
+    Sim::create(w, mode, 240, 120, 55, 0);
+    w.generic = generic;
+    w.lod = lod;
+    // one terminal-sized camera in the middle, like a follow cam would see
+    w.focus[0] = {80, 40, 160, 80};
+    w.num_focus = 1;
+    w.full_thinks = w.cheap_thinks = 0;
+    uint32_t seed = 1;
+    Sim::start_round(w, slots, n, seed);
+    double t0 = now_sec();
+    for (long t=0; t<ticks; t++) {
+        Sim::tick(w);
+        if (w.outcome != Sim::ONGOING) Sim::start_round(w, slots, n, ++seed);
+    }
+    double dt = now_sec() - t0;
+    return dt > 0 ? ticks / dt : 0;
+}
+
+// level-of-detail autotron, microseconds per live bike per tick. slower
+// bikes live longer, so a mixed crowd keeps more of them on the board:
+// per bike is the fair comparison.
+static double bike_cost(Slot* slots, int n, bool mixed, long ticks) {
+    Sim::create(w, MODE_AUTO, 240, 120, 55, 0);
+    w.lod = true;
+    w.focus[0] = {80, 40, 160, 80};
+    w.num_focus = 1;
+    w.mixed_speeds = mixed;
+    uint32_t seed = 1;
+    Sim::start_round(w, slots, n, seed);
+    long live = 0;
+    double t0 = now_sec();
+    for (long t=0; t<ticks; t++) {
+        Sim::tick(w);
+        live += w.alive;
+        if (w.outcome != Sim::ONGOING) Sim::start_round(w, slots, n, ++seed);
+    }
+    double dt = now_sec() - t0;
+    return live ? dt * 1e6 / live : 0;
+}
+
+// crashes per run, and how many were head-on: the cell the bike died
+// entering holds another bike's head
+struct Crashes { long deaths, head_on; double tps; };
+static Crashes crashes(GameMode mode, Slot* slots, int n, bool danger, long ticks) {
+    Sim::create(w, mode, 120, 40, 55, 0);
+    w.track_danger = danger;
+    w.track_events = true;
+    Crashes c{0, 0, 0};
+    uint32_t seed = 1;
+    Sim::start_round(w, slots, n, seed);
+    double t0 = now_sec();
+    int hx[Sim::MAX_PLAYERS], hy[Sim::MAX_PLAYERS];
+    for (long t=0; t<ticks; t++) {
+        for (int i=0; i<w.num_players; i++) { hx[i] = w.players[i].x; hy[i] = w.players[i].y; }
+        Sim::tick(w);
+        // head-on: into the cell the other head was on, or the one it took
+        for (const Sim::Event& e : w.events) {
+            if (e.kind != Sim::EV_DEATH) continue;
+            c.deaths++;
+            if (e.by < 0 || e.by == e.player) continue;
+            int x = e.x + dir_dx((Dir)e.dir), y = e.y + dir_dy((Dir)e.dir);
+            Dir od = w.players[e.by].dir;
+            if ((hx[e.by] == x && hy[e.by] == y) ||
+                (hx[e.by] + dir_dx(od) == x && hy[e.by] + dir_dy(od) == y)) c.head_on++;
+        }
+        w.events.clear();
+        if (w.outcome != Sim::ONGOING) Sim::start_round(w, slots, n, ++seed);
+    }
+    double dt = now_sec() - t0;
+    c.tps = dt > 0 ? ticks / dt : 0;
+    return c;
+}
+
+// share of their pocket that sealed-in bikes fill before they crash
+static double pocket_use(GameMode mode, Slot* slots, bool endgame) {
+    Sim::create(w, mode, 120, 40, 55, 0);
+    w.endgame = endgame;
+    long used = 0, room = 0;
+    for (uint32_t seed=1; seed<=40; seed++) {
+        Sim::start_round(w, slots, 8, seed);
+        while (w.outcome == Sim::ONGOING) Sim::tick(w);
+        // the last bike standing wins without filling its pocket: count the losers
+        for (int i=0; i<w.num_players; i++) {
+            const Player& p = w.players[i];
+            if (p.alone_tick < 0 || p.death_tick < 0) continue;
+            used += p.death_tick - p.alone_tick;
+            room += p.alone_room;
+        }
+    }
+    return room ? 100.0 * used / room : 0;
+}
+
+int Bench::run(int argc, char* argv[]) {
+    long ticks = argc > 2 ? atol(argv[2]) : 200000;
+    if (ticks <= 0) ticks = 200000;
+
+    printf("%-10s %14s %14s %8s\n", "mode", "generic t/s", "per-mode t/s", "speedup");
+    for (int m=0; m<MODE_COUNT; m++) {
+        GameMode mode = (GameMode)m;
+        Slot slots[8];
+        for (int i=0; i<8; i++)
+            slots[i] = {false, (PColor)(i % PC_COUNT), 0, AI_HARD, mode_team_of(mode, i)};
+        double g = ticks_per_sec(mode, slots, mode_players(mode), true, false, ticks);
+        double s = ticks_per_sec(mode, slots, mode_players(mode), false, false, ticks);
+        printf("%-10s %14.0f %14.0f %7.2fx\n", mode_name[m], g, s, g > 0 ? s/g : 0.0);
+    }
+
+    // crowds: every bike on full ai vs the level-of-detail scheduler
+    printf("\n%-10s %14s %14s %8s %9s\n", "autotron", "full t/s", "lod t/s", "speedup", "full/tick");
+    static Slot crowd[Sim::MAX_PLAYERS];
+    for (int i=0; i<Sim::MAX_PLAYERS; i++)
+        crowd[i] = {false, (PColor)(i % PC_COUNT), 0, AI_HARD, 0};
+    for (int n : {8, 16, 32, 64}) {
+        long t = ticks / (n/8);
+        double f = ticks_per_sec(MODE_AUTO, crowd, n, false, false, t);
+        double l = ticks_per_sec(MODE_AUTO, crowd, n, false, true, t);
+        char label[16];
+        snprintf(label, sizeof(label), "%d bikes", n);
+        printf("%-10s %14.0f %14.0f %7.2fx %9.1f\n", label, f, l, f > 0 ? l/f : 0.0,
+               (double)w.full_thinks / t);
+    }
+
+    // the move scheduler only touches bikes that are due: a crowd at mixed
+    // speeds (1, 2/3, 1/2) costs that much less per bike
+    printf("\n%-10s %14s %14s %8s\n", "speeds", "same us/bike", "mixed us/bike", "speedup");
+    for (int n : {16, 64}) {
+        long t = ticks / (n/8);
+        double a = bike_cost(crowd, n, false, t);
+        double b = bike_cost(crowd, n, true, t);
+        char label[16];
+        snprintf(label, sizeof(label), "%d bikes", n);
+        printf("%-10s %14.3f %14.3f %7.2fx\n", label, a, b, b > 0 ? a/b : 0.0);
+    }
+
+    // tournament-style runs: each round played out, then again with
+    // settle_sealed ending it at the seal. saved = ticks the settled run
+    // skipped, agree = how often it named the winner the full one did
+    printf("\n%-10s %7s %12s %12s %7s %7s\n", "to outcome", "rounds", "played tks", "settled tks",
+           "saved", "agree");
+    for (GameMode mode : {MODE_1V1, MODE_FFA, MODE_2V2}) {
+        Slot slots[8];
+        for (int i=0; i<8; i++)
+            slots[i] = {false, (PColor)(i % PC_COUNT), 0, AI_HARD, mode_team_of(mode, i)};
+        Sim::create(w, mode, 120, 40, 55, 0); // a terminal's worth, like fixed play
+        long played = 0, settled = 0;
+        int rounds = 0, judged = 0, agree = 0;
+        for (uint32_t seed=1; seed<=40; seed++) {
+            w.settle_sealed = false;
+            Sim::start_round(w, slots, 8, seed);
+            while (w.outcome == Sim::ONGOING && w.tick < 50000) Sim::tick(w);
+            if (w.outcome == Sim::ONGOING) continue; // never ended: left out
+            bool sealed = w.sealed;
+            int won = w.outcome == Sim::DRAW ? -1 : w.winner;
+            rounds++;
+            played += w.tick;
+
+            w.settle_sealed = true;
+            Sim::start_round(w, slots, 8, seed);
+            while (w.outcome == Sim::ONGOING && w.tick < 50000) Sim::tick(w);
+            settled += w.tick;
+            if (!sealed) continue; // played out the same way: nothing to judge
+            judged++;
+            int lead = w.outcome == Sim::DRAW ? -1 : w.winner;
+            if (lead == won || (lead >= 0 && won >= 0 && mode_teams(mode) &&
+                                w.players[lead].team == w.players[won].team)) agree++;
+        }
+        w.settle_sealed = false;
+        printf("%-10s %7d %12.0f %12.0f %6.0f%% %6.0f%%\n", mode_name[mode], rounds,
+               rounds ? (double)played / rounds : 0.0, rounds ? (double)settled / rounds : 0.0,
+               played ? 100.0 * (played - settled) / played : 0.0,
+               judged ? 100.0 * agree / judged : 0.0);
+    }
+
+    printf("\n%-10s %14s %14s\n", "pockets", "ai filled", "endgame filled");
+    for (GameMode mode : {MODE_1V1, MODE_FFA}) {
+        Slot slots[8];
+        for (int i=0; i<8; i++) slots[i] = {false, (PColor)(i % PC_COUNT), 0, AI_HARD, 0};
+        printf("%-10s %13.0f%% %13.0f%%\n", mode_name[mode],
+               pocket_use(mode, slots, false), pocket_use(mode, slots, true));
+    }
+
+    // the shared head-reach map: head-on crashes (per 100 crashes) and speed
+    printf("\n%-10s %9s %9s %14s %14s\n", "danger", "head-on", "with map", "t/s", "with map t/s");
+    for (GameMode mode : {MODE_1V1, MODE_FFA, MODE_AUTO}) {
+        int n = mode == MODE_AUTO ? 16 : mode_players(mode);
+        Slot* slots = mode == MODE_AUTO ? crowd : nullptr;
+        Slot fixed[8];
+        for (int i=0; i<8; i++) fixed[i] = {false, (PColor)(i % PC_COUNT), 0, AI_HARD, 0};
+        if (!slots) slots = fixed;
+        Crashes off = crashes(mode, slots, n, false, ticks / 2);
+        Crashes on  = crashes(mode, slots, n, true,  ticks / 2);
+        char label[24];
+        snprintf(label, sizeof(label), mode == MODE_AUTO ? "%s %d" : "%s", mode_name[mode], n);
+        printf("%-10s %8.1f%% %8.1f%% %14.0f %14.0f\n", label,
+               off.deaths ? 100.0 * off.head_on / off.deaths : 0.0,
+               on.deaths ? 100.0 * on.head_on / on.deaths : 0.0, off.tps, on.tps);
+    }
+    return 0;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+namespace Bench {
+    // ./tron bench [ticks]: headless sim throughput, generic vs per-mode kernels
+    int run(int argc, char* argv[]);
+}
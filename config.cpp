@@ -1,17 +1,19 @@
 #include "config.h"
+#include "arena.h"
+#include "sim.h"
 #include <fstream>
 #include <cstdlib>
 #include <sys/stat.h>
 
-static std::string config_dir() {
+std::string Config::dir() {
     const char* home = getenv("HOME");
     return std::string(home ? home : "/tmp") + "/.config/tron";
 }
 
 void Config::init() {
-    std::string dir = config_dir();
-    mkdir(dir.substr(0, dir.rfind('/')).c_str(), 0755);
-    mkdir(dir.c_str(), 0755);
+    std::string d = dir();
+    mkdir(d.substr(0, d.rfind('/')).c_str(), 0755);
+    mkdir(d.c_str(), 0755);
     load();
     load_scores();
 }
@@ -20,7 +22,7 @@ static Config::Settings settings;
 Config::Settings& Config::get() { return settings; }
 
 void Config::save() {
-    std::ofstream f(config_dir() + "/settings");
+    std::ofstream f(dir() + "/settings");
     if (!f) return;
     f << (int)settings.last_mode << ' ' << settings.tick_ms << '\n';
     for (int i = 0; i < 8; i++) {
@@ -28,10 +30,15 @@ void Config::save() {
         f << sl.human << ' ' << (int)sl.color << ' ' << sl.keyset
           << ' ' << (int)sl.diff << ' ' << sl.team << '\n';
     }
+    // appended after the slots so older settings files still parse
+    f << settings.trail_len << '\n';
+    f << settings.arena << '\n';
+    f << settings.crowd << '\n';
+    f << settings.speeds << '\n';
 }
 
 void Config::load() {
-    std::ifstream f(config_dir() + "/settings");
+    std::ifstream f(dir() + "/settings");
     if (!f) {
         PColor cols[] = {PC_CYAN,PC_MAGENTA,PC_GREEN,PC_YELLOW,PC_RED,PC_BLUE,PC_WHITE,PC_ORANGE};
         for (int i=0;i<8;i++)
@@ -45,13 +52,19 @@ void Config::load() {
         if (!(f >> h >> c >> k >> d >> t)) break;
         settings.slots[i] = {(bool)h, (PColor)c, k, (AIDiff)d, t};
     }
+    if (!(f >> settings.trail_len) || settings.trail_len < 0) settings.trail_len = 0;
+    if (!(f >> settings.arena) || settings.arena < 0 || settings.arena >= Arena::KIND_COUNT)
+        settings.arena = 0;
+    if (!(f >> settings.crowd) || settings.crowd < 0 || settings.crowd > Sim::MAX_PLAYERS)
+        settings.crowd = 0;
+    if (!(f >> settings.speeds) || settings.speeds < 0 || settings.speeds > 1) settings.speeds = 0;
 }
 
 static ScoreData score_data;
 ScoreData& Config::scores() { return score_data; }
 
 void Config::save_scores() {
-    std::ofstream f(config_dir() + "/scores");
+    std::ofstream f(dir() + "/scores");
     if (!f) return;
     auto& s = score_data;
     f << s.total_wins << ' ' << s.best_streak << ' ' << s.current_streak
@@ -59,7 +72,7 @@ void Config::save_scores() {
 }
 
 void Config::load_scores() {
-    std::ifstream f(config_dir() + "/scores");
+    std::ifstream f(dir() + "/scores");
     if (!f) return;
     f >> score_data.total_wins >> score_data.best_streak >> score_data.current_streak
       >> score_data.rounds_played >> score_data.best_time >> score_data.best_endless;
@@ -3,10 +3,15 @@
 
 namespace Config {
     void init();
+    std::string dir(); // ~/.config/tron
 
     struct Settings {
         GameMode last_mode = MODE_1V1;
         int      tick_ms   = 55;
+        int      trail_len = 0;    // max cells per trail, 0 = unlimited
+        int      arena     = 0;    // Arena::Kind generated per round, 0 = open box
+        int      crowd     = 0;    // bikes in Endless/AutoTron, 0 = mode default
+        int      speeds    = 0;    // Endless/AutoTron cpu bikes: 0 = one speed, 1 = mixed
         Slot     slots[8];
     };
 
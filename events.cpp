@@ -0,0 +1,108 @@
+#include "events.h"
+#include "types.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <unistd.h>
+
+// single producer (the game loop), single consumer (the writer thread).
+// head/tail only ever grow; the slot is the count mod the ring size.
+namespace {
+constexpr size_t RING = 1 << 16;
+
+Events::Record ring[RING];
+std::atomic<uint64_t> head{0}, tail{0}; // written by the producer / the writer
+std::atomic<bool> running{false};
+std::atomic<long> dropped{0};
+FILE* out = nullptr;
+std::thread writer;
+
+const char* dir_str(uint8_t d) {
+    static const char* s[] = {"up","down","left","right","none"};
+    return d < 5 ? s[d] : "none";
+}
+
+const char* outcome_str(int o) {
+    static const char* s[] = {"aborted","winner","team_win","draw","humans_out"}; // Sim::Outcome
+    return o >= 0 && o < 5 ? s[o] : "?";
+}
+
+void write_one(const Events::Record& r) {
+    using namespace Events;
+    int rd = r.round, t = r.tick, p = r.player;
+    switch (r.kind) {
+    case ROUND_START:
+        fprintf(out, "{\"ev\":\"round_start\",\"round\":%d,\"mode\":\"%s\",\"w\":%d,\"h\":%d,"
+                     "\"bikes\":%d,\"seed\":%u}\n",
+                rd, r.a >= 0 && r.a < MODE_COUNT ? mode_name[r.a] : "?", r.x, r.y, r.b, r.seed);
+        break;
+    case SPAWN: case RESPAWN:
+        fprintf(out, "{\"ev\":\"%s\",\"round\":%d,\"tick\":%d,\"p\":%d,\"x\":%d,\"y\":%d,\"dir\":\"%s\"}\n",
+                r.kind == SPAWN ? "spawn" : "respawn", rd, t, p, r.x, r.y, dir_str(r.dir));
+        break;
+    case TURN:
+        fprintf(out, "{\"ev\":\"turn\",\"round\":%d,\"tick\":%d,\"p\":%d,\"x\":%d,\"y\":%d,\"dir\":\"%s\"}\n",
+                rd, t, p, r.x, r.y, dir_str(r.dir));
+        break;
+    case DEATH:
+        if (r.a < 0)
+            fprintf(out, "{\"ev\":\"death\",\"round\":%d,\"tick\":%d,\"p\":%d,\"x\":%d,\"y\":%d,"
+                         "\"by\":\"wall\"}\n", rd, t, p, r.x, r.y);
+        else
+            fprintf(out, "{\"ev\":\"death\",\"round\":%d,\"tick\":%d,\"p\":%d,\"x\":%d,\"y\":%d,"
+                         "\"by\":%d}\n", rd, t, p, r.x, r.y, r.a);
+        break;
+    case CAMERA:
+        fprintf(out, "{\"ev\":\"camera\",\"round\":%d,\"tick\":%d,\"view\":%d,\"follow\":%d}\n",
+                rd, t, p, r.a);
+        break;
+    case ROUND_END:
+        fprintf(out, "{\"ev\":\"round_end\",\"round\":%d,\"tick\":%d,\"outcome\":\"%s\",\"winner\":%d}\n",
+                rd, t, outcome_str(r.a), r.b);
+        break;
+    }
+}
+
+void write_loop() {
+    for (;;) {
+        bool stop = !running.load(std::memory_order_acquire);
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        for (; t != h; t++) write_one(ring[t % RING]);
+        tail.store(t, std::memory_order_release);
+        if (stop) break; // anything pushed before the stop flag is written
+        fflush(out);
+        usleep(20000);
+    }
+    fflush(out);
+}
+}
+
+bool Events::open(const std::string& path) {
+    out = fopen(path.c_str(), "w");
+    if (!out) return false;
+    head = tail = 0;
+    dropped = 0;
+    running = true;
+    writer = std::thread(write_loop);
+    return true;
+}
+
+bool Events::enabled() { return out != nullptr; }
+
+void Events::emit(const Record& r) {
+    if (!out) return;
+    uint64_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= RING) { dropped++; return; }
+    ring[h % RING] = r;
+    head.store(h + 1, std::memory_order_release);
+}
+
+long Events::close() {
+    if (!out) return 0;
+    running.store(false, std::memory_order_release);
+    writer.join();
+    fclose(out);
+    out = nullptr;
+    return dropped;
+}
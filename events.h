@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// --events FILE: one JSON object per line for everything that happens in a
+// round. emit() only copies a fixed-size record into a preallocated ring; a
+// background thread formats and writes, so a slow disk never stalls a tick.
+// if the ring fills up the record is dropped (and counted) instead.
+namespace Events {
+    enum Kind : uint8_t {
+        ROUND_START=0, SPAWN, TURN, DEATH, RESPAWN, CAMERA, ROUND_END
+    };
+
+    struct Record {
+        Kind     kind;
+        uint8_t  dir;      // Dir: SPAWN, TURN, RESPAWN
+        int16_t  player;   // bike index; CAMERA: view
+        int16_t  x, y;     // ROUND_START: world size
+        int16_t  a;        // DEATH: killer (-1 wall), CAMERA: followed bike,
+                           // ROUND_START: mode, ROUND_END: Sim::Outcome
+                           // (ONGOING = quit or restarted)
+        int16_t  b;        // ROUND_START: bikes, ROUND_END: winner
+        int32_t  round, tick;
+        uint32_t seed;     // ROUND_START
+    };
+
+    // truncates FILE and starts the writer; false if it can't be opened
+    bool open(const std::string& path);
+    bool enabled();
+    void emit(const Record& r);
+    // drains what's queued, stops the writer. returns records dropped.
+    long close();
+}
@@ -1,224 +1,247 @@
 #include "game.h"
 #include "config.h"
+#include "history.h"
+#include "sim.h"
+#include "arena.h"
+#include "events.h"
+#include "latency.h"
+#include "snapshot.h"
+#include "spectate.h"
+#include "quality.h"
+#include <climits>
 #include <cstring>
 #include <cstdlib>
 #include <ctime>
 #include <cmath>
 #include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
 #include <vector>
 #include <algorithm>
 
+static Game::Options options;
+Game::Options& Game::opts() { return options; }
+
 // world grid (may be larger than screen)
 static int GW, GH;
-// screen/viewport size
+// screen size (minus the hud row)
 static int SW, SH;
-// camera top-left corner in world coords
-static int cam_x, cam_y;
 static bool use_camera;
 
-static Cell* grid;
-static Dir*  prev_dir;
-static uint8_t* trail_glyph; // cached glyph index per cell
-
-// glyph indices matching Trail:: constants
-enum TGlyph : uint8_t {
-    TG_NONE=0, TG_V, TG_H, TG_UL, TG_UR, TG_DL, TG_DR, TG_HD
+// a camera viewport onto the world, full screen width. split-screen stacks two
+// of them; each remembers what it last drew so a frame only touches changed cells.
+struct View {
+    int top, h;                   // screen rows [top, top+h)
+    int cam_x, cam_y;             // camera top-left corner in world coords
+    int drawn_x, drawn_y;         // camera position the shadow was drawn at
+    int follow;                   // player index this camera tracks
+    int framed;                   // who the camera was last placed for, -1 = recenter
+    std::vector<uint16_t> shadow; // per screen cell: (cell<<8 | glyph) last drawn
 };
+constexpr uint16_t SHADOW_DIRTY = 0xffff;
+constexpr uint16_t SHADOW_VOID  = 0xfffe; // outside the world
+constexpr uint16_t SHADOW_TOUCH = 0xfffd; // drawn over by an overlay
+static View views[2];
+static int  num_views;
+static View* cv = &views[0]; // view currently being drawn
+
+// the simulation lives in sim.cpp; this file feeds it input and draws it
+static Sim::World world;
+static Arena::Map arena; // loaded from --map, or regenerated each round
+
 static const char* tg_str[] = {
     " ", Trail::V, Trail::H, Trail::UL, Trail::UR, Trail::DL, Trail::DR, Trail::HD
 };
-
-static uint8_t corner_glyph(Dir from, Dir to) {
-    if (from==to || from==D_NONE) return (to==D_UP||to==D_DOWN)?TG_V:TG_H;
-    if ((from==D_UP   &&to==D_RIGHT)||(from==D_LEFT &&to==D_DOWN))  return TG_UL;
-    if ((from==D_UP   &&to==D_LEFT) ||(from==D_RIGHT&&to==D_DOWN))  return TG_UR;
-    if ((from==D_DOWN &&to==D_RIGHT)||(from==D_LEFT &&to==D_UP))    return TG_DL;
-    if ((from==D_DOWN &&to==D_LEFT) ||(from==D_RIGHT&&to==D_UP))    return TG_DR;
-    return (to==D_UP||to==D_DOWN)?TG_V:TG_H;
+// one byte a cell, for links too slow for the box glyphs (Quality::ASCII)
+static const char* tg_ascii[] = {" ", "|", "-", "+", "+", "+", "+", "@"};
+
+// wall glyph joined up with its wall neighbours (bits: up, down, left, right)
+static const char* wall_str(int x, int y) {
+    static const char* joins[16] = {
+        "▪", "│", "│", "│", "─", "╯", "╮", "┤",
+        "─", "╰", "╭", "├", "─", "┴", "┬", "┼",
+    };
+    auto wall = [](int x, int y) {
+        return x>=0 && x<GW && y>=0 && y<GH && world.grid[world.idx(x,y)] == C_WALL;
+    };
+    static const char* ascii[16] = {
+        "#", "|", "|", "|", "-", "+", "+", "+",
+        "-", "+", "+", "+", "-", "+", "+", "+",
+    };
+    int m = wall(x,y-1) | wall(x,y+1)<<1 | wall(x-1,y)<<2 | wall(x+1,y)<<3;
+    return Quality::ascii() ? ascii[m] : joins[m];
 }
 
-static inline int idx(int x, int y) { return y*GW+x; }
+// world -> screen conversion (current view)
+static inline int scr_x(int wx) { return wx - cv->cam_x; }
+static inline int scr_y(int wy) { return wy - cv->cam_y + cv->top; }
+// is a screen position inside the area being drawn?
+static inline bool in_view(int sx, int sy) {
+    if (!use_camera) return sx>=0 && sx<SW && sy>=0 && sy<SH;
+    return sx>=0 && sx<SW && sy>=cv->top && sy<cv->top+cv->h;
+}
 
-static inline bool blocked_for(int x, int y, int team, GameMode mode) {
-    if (x<=0||x>=GW-1||y<=0||y>=GH-1) return true;
-    Cell c = grid[idx(x,y)];
-    if (c==C_EMPTY) return false;
-    if (c==C_WALL) return true;
-    if (mode==MODE_2V2) {
-        int cell_team = ((int)c - (int)C_P1) / 2;
-        if (cell_team == team) return false;
+// something other than render_viewport drew here; repaint it next frame
+static inline void view_touch(int sy, int sx) {
+    for (int v=0; v<num_views; v++) {
+        View& vw = views[v];
+        if (sy>=vw.top && sy<vw.top+vw.h && sx>=0 && sx<SW)
+            vw.shadow[(sy-vw.top)*SW + sx] = SHADOW_TOUCH;
     }
-    return true;
 }
 
-static void grid_init() {
-    std::memset(grid, C_EMPTY, GW*GH*sizeof(Cell));
-    for (int i=0; i<GW*GH; i++) { prev_dir[i] = D_NONE; trail_glyph[i] = TG_NONE; }
-    for (int x=0;x<GW;x++) { grid[idx(x,0)]=C_WALL; grid[idx(x,GH-1)]=C_WALL; }
-    for (int y=0;y<GH;y++) { grid[idx(0,y)]=C_WALL; grid[idx(GW-1,y)]=C_WALL; }
+static void views_invalidate() {
+    for (int v=0; v<num_views; v++) {
+        std::fill(views[v].shadow.begin(), views[v].shadow.end(), SHADOW_DIRTY);
+        views[v].framed = -1;
+    }
 }
 
-// world -> screen conversion
-static inline int scr_x(int wx) { return wx - cam_x; }
-static inline int scr_y(int wy) { return wy - cam_y; }
-static inline bool on_screen(int wx, int wy) {
-    int sx = scr_x(wx), sy = scr_y(wy);
-    return sx>=0 && sx<SW && sy>=0 && sy<SH;
+static void clamp_cam(View& v) {
+    if (v.cam_x < 0) v.cam_x = 0;
+    if (v.cam_y < 0) v.cam_y = 0;
+    if (v.cam_x + SW > GW) v.cam_x = GW - SW;
+    if (v.cam_y + v.h > GH) v.cam_y = GH - v.h;
 }
 
 // center camera on a world position
-static void center_cam(int wx, int wy) {
-    cam_x = wx - SW/2;
-    cam_y = wy - SH/2;
-    if (cam_x < 0) cam_x = 0;
-    if (cam_y < 0) cam_y = 0;
-    if (cam_x + SW > GW) cam_x = GW - SW;
-    if (cam_y + SH > GH) cam_y = GH - SH;
-}
-
-// full viewport redraw - reads cached glyphs
-static void render_viewport() {
-    for (int sy=0; sy<SH; sy++) {
+static void center_cam(View& v, int wx, int wy) {
+    v.cam_x = wx - SW/2;
+    v.cam_y = wy - v.h/2;
+    clamp_cam(v);
+}
+
+// dead-zone follow: the camera holds still while the head stays in the middle
+// half of the view, then recenters along the axis it left by. most frames
+// reuse what's on screen, and vertical jumps become a scroll.
+static void follow_cam(View& v, int wx, int wy) {
+    int sx = wx - v.cam_x, sy = wy - v.cam_y;
+    if (v.framed != v.follow || sx < 0 || sx >= SW || sy < 0 || sy >= v.h) {
+        v.framed = v.follow;
+        center_cam(v, wx, wy);
+        return;
+    }
+    if (sx < SW/4  || sx >= SW - SW/4)   v.cam_x = wx - SW/2;
+    if (sy < v.h/4 || sy >= v.h - v.h/4) v.cam_y = wy - v.h/2;
+    clamp_cam(v);
+}
+
+// the camera moved dy rows: the terminal shifts the view's rows itself
+// (scrolling region), the shadow shifts to match, and only rows that came
+// into view are left to draw
+static void scroll_view(View& v, int dy) {
+    setscrreg(v.top, v.top + v.h - 1);
+    scrollok(stdscr, TRUE);
+    scrl(dy);
+    scrollok(stdscr, FALSE);
+    setscrreg(0, LINES - 1);
+    int keep = (v.h - std::abs(dy)) * SW;
+    uint16_t* s = v.shadow.data();
+    if (dy > 0) {
+        std::memmove(s, s + dy*SW, keep * sizeof(uint16_t));
+        std::fill(s + keep, s + v.h*SW, SHADOW_DIRTY);
+    } else {
+        std::memmove(s - dy*SW, s, keep * sizeof(uint16_t));
+        std::fill(s, s - dy*SW, SHADOW_DIRTY);
+    }
+}
+
+// viewport redraw from cached glyphs; only cells that differ from the
+// view's shadow are emitted. on a byte budget (Quality) the cells that
+// changed since they were drawn go first, scroll fills and repaints after,
+// and whatever doesn't fit keeps its old shadow for a later frame.
+static void render_viewport(View& v) {
+    if (v.cam_x != v.drawn_x || v.cam_y != v.drawn_y) {
+        int dy = v.cam_y - v.drawn_y;
+        if (v.cam_x == v.drawn_x && std::abs(dy) < v.h) scroll_view(v, dy);
+        else std::fill(v.shadow.begin(), v.shadow.end(), SHADOW_DIRTY);
+        v.drawn_x = v.cam_x; v.drawn_y = v.cam_y;
+    }
+    const char* const* tg = Quality::ascii() ? tg_ascii : tg_str;
+    int left = Quality::cells(), painted = 0, deferred = 0;
+    bool budget = left != INT_MAX;
+    for (int pass = 0; pass < (budget ? 2 : 1); pass++)
+    for (int vy=0; vy<v.h; vy++) {
+        int sy = v.top + vy;
+        uint16_t* shadow = &v.shadow[vy*SW];
         for (int sx=0; sx<SW; sx++) {
-            int wx = cam_x + sx;
-            int wy = cam_y + sy;
-            if (wx<0||wx>=GW||wy<0||wy>=GH) {
-                mvaddch(sy, sx, ' ');
-                continue;
+            int wx = v.cam_x + sx;
+            int wy = v.cam_y + vy;
+            bool out = wx<0||wx>=GW||wy<0||wy>=GH;
+            Cell c = out ? C_EMPTY : world.grid[world.idx(wx,wy)];
+            uint16_t key = out ? SHADOW_VOID : (uint16_t)(c << 8 | world.trail_glyph[world.idx(wx,wy)]);
+            if (shadow[sx] == key) continue;
+            if (budget) {
+                if ((pass == 0) == (shadow[sx] == SHADOW_DIRTY)) continue; // not this pass's
+                if (painted >= left) { deferred++; continue; }
             }
-            Cell c = grid[idx(wx,wy)];
+            painted++;
+            shadow[sx] = key;
             if (c == C_EMPTY) {
                 mvaddch(sy, sx, ' ');
             } else if (c == C_WALL) {
-                bool top = (wy==0), bot = (wy==GH-1);
-                bool lft = (wx==0), rgt = (wx==GW-1);
                 attron(COLOR_PAIR(CP_WALL) | A_DIM);
-                if (top && lft)      mvaddstr(sy,sx,"╭");
-                else if (top && rgt) mvaddstr(sy,sx,"╮");
-                else if (bot && lft) mvaddstr(sy,sx,"╰");
-                else if (bot && rgt) mvaddstr(sy,sx,"╯");
-                else if (top||bot)   mvaddstr(sy,sx,"─");
-                else                 mvaddstr(sy,sx,"│");
+                mvaddstr(sy, sx, wall_str(wx, wy));
                 attroff(COLOR_PAIR(CP_WALL) | A_DIM);
             } else {
-                int pi = (int)c - (int)C_P1;
-                uint8_t g = trail_glyph[idx(wx,wy)];
-                const char* ch = (g < sizeof(tg_str)/sizeof(tg_str[0])) ? tg_str[g] : Trail::HD;
-                attron(COLOR_PAIR(CP_TRAIL(pi)) | A_BOLD);
+                int pair = CP_TRAIL(Sim::cell_color(world, c));
+                uint8_t g = world.trail_glyph[world.idx(wx,wy)];
+                const char* ch = (g < sizeof(tg_str)/sizeof(tg_str[0])) ? tg[g] : tg[TG_HD];
+                attron(COLOR_PAIR(pair) | A_BOLD);
                 mvaddstr(sy, sx, ch);
-                attroff(COLOR_PAIR(CP_TRAIL(pi)) | A_BOLD);
+                attroff(COLOR_PAIR(pair) | A_BOLD);
             }
         }
     }
+    Quality::painted(painted, deferred);
 }
 
-// fixed-camera border draw (for non-camera modes)
-static void draw_border() {
+// fixed-camera wall draw (for non-camera modes)
+static void draw_walls() {
     attron(COLOR_PAIR(CP_WALL) | A_DIM);
-    for (int x=0;x<GW;x++) { mvaddstr(0,x,"─"); mvaddstr(GH-1,x,"─"); }
-    for (int y=0;y<GH;y++) { mvaddstr(y,0,"│"); mvaddstr(y,GW-1,"│"); }
-    mvaddstr(0,0,"╭"); mvaddstr(0,GW-1,"╮");
-    mvaddstr(GH-1,0,"╰"); mvaddstr(GH-1,GW-1,"╯");
+    for (int y=0;y<GH;y++)
+        for (int x=0;x<GW;x++)
+            if (world.grid[world.idx(x,y)] == C_WALL) mvaddstr(y, x, wall_str(x, y));
     attroff(COLOR_PAIR(CP_WALL) | A_DIM);
 }
 
-struct Player {
-    int x, y;
-    Dir dir;
-    bool alive;
-    bool active;
-    Slot* slot;
-    Cell cell;
-    int index;
-    int death_tick;
-    int label_tick;
-    std::vector<std::pair<int,int>> trail_cells;
-};
+// minimap (camera modes): the sim keeps per-block, per-color trail counts
+// (Sim::enable_blocks), so drawing the minimap never rescans the grid however
+// big the world is.
+static bool show_minimap = true;
 
-static Player players[8];
-static int num_players;
-
-static void find_spawn(int &sx, int &sy, Dir &sd) {
-    for (int attempts=0; attempts<500; attempts++) {
-        sx = 4 + rand() % (GW-8);
-        sy = 4 + rand() % (GH-8);
-        if (grid[idx(sx,sy)] != C_EMPTY) continue;
-        Dir dirs[] = {D_UP, D_DOWN, D_LEFT, D_RIGHT};
-        for (int d=0; d<4; d++) {
-            int nx = sx+dir_dx(dirs[d]), ny = sy+dir_dy(dirs[d]);
-            if (nx>0 && nx<GW-1 && ny>0 && ny<GH-1 && grid[idx(nx,ny)]==C_EMPTY) {
-                sd = dirs[d];
-                return;
-            }
-        }
-    }
-    sx = GW/2; sy = GH/2; sd = D_RIGHT;
-}
-
-static void spawn_player(Player& p) {
-    int sx, sy; Dir sd;
-    find_spawn(sx, sy, sd);
-    p.x = sx; p.y = sy; p.dir = sd;
-    p.alive = true; p.active = true;
-    p.death_tick = -1;
-    p.label_tick = -1;
-    p.trail_cells.clear();
-    grid[idx(sx,sy)] = p.cell;
-    prev_dir[idx(sx,sy)] = sd;
-    trail_glyph[idx(sx,sy)] = TG_HD;
-    p.trail_cells.push_back({sx,sy});
-}
-
-static void spawn_players_fixed(GameMode mode, Slot slots[8]) {
-    num_players = mode_players(mode);
-    struct { float fx, fy; Dir d; } pos[] = {
-        {0.25f, 0.50f, D_RIGHT}, {0.75f, 0.50f, D_LEFT},
-        {0.25f, 0.25f, D_RIGHT}, {0.75f, 0.25f, D_LEFT},
-        {0.25f, 0.75f, D_RIGHT}, {0.75f, 0.75f, D_LEFT},
-        {0.50f, 0.25f, D_DOWN},  {0.50f, 0.75f, D_UP},
-    };
-    for (int i=0; i<num_players; i++) {
-        Player& p = players[i];
-        p.slot = &slots[i]; p.cell = (Cell)(C_P1+i); p.index = i;
-        p.alive = true; p.active = true;
-        p.death_tick = -1; p.label_tick = -1;
-        p.trail_cells.clear();
-        p.x = (int)(pos[i].fx * GW);
-        p.y = (int)(pos[i].fy * GH);
-        if (p.x<=1) p.x=2;
-        if (p.x>=GW-2) p.x=GW-3;
-        if (p.y<=1) p.y=2;
-        if (p.y>=GH-2) p.y=GH-3;
-        p.dir = pos[i].d;
-        grid[idx(p.x,p.y)] = p.cell;
-        prev_dir[idx(p.x,p.y)] = p.dir;
-        trail_glyph[idx(p.x,p.y)] = TG_HD;
-        p.trail_cells.push_back({p.x,p.y});
-    }
-}
-
-// incremental trail draw (fixed camera only)
-static void draw_trail_seg(Player& p, Dir old_dir) {
-    int ox = p.x - dir_dx(p.dir);
-    int oy = p.y - dir_dy(p.dir);
-    if (ox>0 && ox<GW-1 && oy>0 && oy<GH-1) {
-        attron(COLOR_PAIR(CP_TRAIL(p.slot->color)) | A_BOLD);
-        mvaddstr(oy, ox, Trail::corner(old_dir, p.dir));
-        attroff(COLOR_PAIR(CP_TRAIL(p.slot->color)) | A_BOLD);
+static void mm_init() {
+    if (!use_camera) return;
+    int w = std::clamp(SW/5, 12, 40);
+    int h = std::clamp(w * GH / GW / 2, 4, views[0].h/3); // terminal cells are ~2:1
+    Sim::enable_blocks(world, (GW + w - 1) / w, (GH + h - 1) / h);
+}
+
+// fixed camera: redraw just the cells the last tick changed
+static void draw_dirty() {
+    for (int i : world.dirty) {
+        int x = i % GW, y = i / GW;
+        Cell c = world.grid[i];
+        if (c == C_EMPTY) { mvaddch(y, x, ' '); continue; }
+        uint8_t g = world.trail_glyph[i];
+        int color = Sim::cell_color(world, c);
+        int pair = g == TG_HD ? CP_HEAD(color) : CP_TRAIL(color);
+        attron(COLOR_PAIR(pair) | A_BOLD);
+        mvaddstr(y, x, tg_str[g]);
+        attroff(COLOR_PAIR(pair) | A_BOLD);
     }
-    attron(COLOR_PAIR(CP_HEAD(p.slot->color)) | A_BOLD);
-    mvaddstr(p.y, p.x, Trail::HD);
-    attroff(COLOR_PAIR(CP_HEAD(p.slot->color)) | A_BOLD);
+    world.dirty.clear();
 }
 
 // draw head at screen position (works for both modes)
 static void draw_head_at(Player& p) {
     int sx = use_camera ? scr_x(p.x) : p.x;
     int sy = use_camera ? scr_y(p.y) : p.y;
-    if (sx>=0 && sx<SW && sy>=0 && sy<SH) {
+    if (in_view(sx, sy)) {
         attron(COLOR_PAIR(CP_HEAD(p.slot->color)) | A_BOLD);
-        mvaddstr(sy, sx, Trail::HD);
+        mvaddstr(sy, sx, use_camera && Quality::ascii() ? tg_ascii[TG_HD] : Trail::HD);
         attroff(COLOR_PAIR(CP_HEAD(p.slot->color)) | A_BOLD);
+        view_touch(sy, sx);
     }
 }
 
@@ -235,49 +258,47 @@ static void draw_label(Player& p) {
     int wx = p.x, wy = p.y;
     int sx = (use_camera ? scr_x(wx) : wx) - (int)strlen(buf)/2;
     int sy = (use_camera ? scr_y(wy) : wy) - 1;
-    if (sy < 0) sy += 2;
+    int top = use_camera ? cv->top : 0;
+    if (sy < top) sy += 2;
     if (sx < 0) sx = 0;
     if (sx + (int)strlen(buf) >= SW) sx = SW - 1 - (int)strlen(buf);
     attron(COLOR_PAIR(CP_TRAIL(p.slot->color)) | A_BOLD);
     mvaddstr(sy, sx, buf);
     attroff(COLOR_PAIR(CP_TRAIL(p.slot->color)) | A_BOLD);
+    for (int i=0; i<(int)strlen(buf); i++) view_touch(sy, sx+i);
 }
 
 static void erase_label(Player& p) {
     int wx = p.x, wy = p.y;
     int sy = (use_camera ? scr_y(wy) : wy) - 1;
-    if (sy < 0) sy += 2;
+    int top = use_camera ? cv->top : 0;
+    if (sy < top) sy += 2;
     for (int dx = -2; dx <= 4; dx++) {
         int ex = (use_camera ? scr_x(wx) : wx) + dx;
-        if (ex >= 0 && ex < SW && sy >= 0 && sy < SH) {
+        if (in_view(ex, sy)) {
             // only clear if the underlying grid cell is empty
-            int gwx = (use_camera ? cam_x : 0) + ex;
-            int gwy = (use_camera ? cam_y : 0) + sy;
-            if (gwx>=0 && gwx<GW && gwy>=0 && gwy<GH && grid[idx(gwx,gwy)]==C_EMPTY)
+            int gwx = (use_camera ? cv->cam_x : 0) + ex;
+            int gwy = (use_camera ? cv->cam_y - cv->top : 0) + sy;
+            if (gwx>=0 && gwx<GW && gwy>=0 && gwy<GH && world.grid[world.idx(gwx,gwy)]==C_EMPTY)
                 mvaddch(sy, ex, ' ');
         }
     }
 }
 
-static void erase_trail(Player& p) {
-    for (auto& [cx,cy] : p.trail_cells) {
-        if (cx>0 && cx<GW-1 && cy>0 && cy<GH-1) {
-            grid[idx(cx,cy)] = C_EMPTY;
-            prev_dir[idx(cx,cy)] = D_NONE;
-            trail_glyph[idx(cx,cy)] = TG_NONE;
-            if (!use_camera) mvaddch(cy, cx, ' ');
-        }
-    }
-    p.trail_cells.clear();
-}
-
+// only the trail segments that cross the view being drawn are walked, so a
+// long trail mostly off-camera flashes as cheaply as a short one
 static void flash_trail(Player& p, bool bright) {
     int pair = CP_TRAIL(p.slot->color);
-    for (auto& [cx,cy] : p.trail_cells) {
-        if (cx<=0 || cx>=GW-1 || cy<=0 || cy>=GH-1) continue;
+    int x0 = 1, y0 = 1, x1 = GW-2, y1 = GH-2;
+    if (use_camera) {
+        x0 = std::max(x0, cv->cam_x); x1 = std::min(x1, cv->cam_x + SW-1);
+        y0 = std::max(y0, cv->cam_y); y1 = std::min(y1, cv->cam_y + cv->h-1);
+    } else {
+        x1 = std::min(x1, SW-1); y1 = std::min(y1, SH-1);
+    }
+    p.trail.each_in(x0, y0, x1, y1, [&](int cx, int cy) {
         int sx = use_camera ? scr_x(cx) : cx;
         int sy = use_camera ? scr_y(cy) : cy;
-        if (sx<0||sx>=SW||sy<0||sy>=SH) continue;
         if (bright) {
             attron(COLOR_PAIR(pair) | A_BOLD);
             mvaddstr(sy, sx, "█");
@@ -285,51 +306,36 @@ static void flash_trail(Player& p, bool bright) {
         } else {
             mvaddch(sy, sx, ' ');
         }
-    }
+        view_touch(sy, sx);
+    });
 }
 
-// find the camera follow target for autotron
+// find the camera follow target for autotron: the longest trail, or whoever
+// respawns soonest if nobody is alive
 static int find_follow_target() {
-    int best = -1, best_len = -1;
-    for (int i=0; i<num_players; i++) {
-        if (!players[i].alive || !players[i].active) continue;
-        int len = (int)players[i].trail_cells.size();
-        if (len > best_len) { best_len = len; best = i; }
-    }
-    // nobody alive? find first one that will respawn soonest (lowest death_tick)
-    if (best < 0) {
-        int earliest = 999999999;
-        for (int i=0; i<num_players; i++) {
-            if (players[i].death_tick >= 0 && players[i].death_tick < earliest) {
-                earliest = players[i].death_tick;
-                best = i;
-            }
-        }
-    }
-    // absolute fallback
-    if (best < 0) best = 0;
-    return best;
+    int best = Sim::longest_trail(world);
+    return best < 0 ? 0 : best;
 }
 
 // draw proximity arrow to nearest alive enemy (endless only)
 static void draw_nearest_arrow(int follow_idx) {
-    Player& me = players[follow_idx];
+    Player& me = world.players[follow_idx];
     if (!me.alive) return;
 
     int nearest = -1;
     double nearest_dist = 1e9;
-    for (int i=0; i<num_players; i++) {
-        if (i == follow_idx || !players[i].alive || !players[i].active) continue;
-        double dx = players[i].x - me.x;
-        double dy = players[i].y - me.y;
+    for (int i=0; i<world.num_players; i++) {
+        if (i == follow_idx || !world.players[i].alive || !world.players[i].active) continue;
+        double dx = world.players[i].x - me.x;
+        double dy = world.players[i].y - me.y;
         double d = sqrt(dx*dx + dy*dy);
         if (d < nearest_dist) { nearest_dist = d; nearest = i; }
     }
     if (nearest < 0) return;
 
     // direction from me to them
-    double dx = players[nearest].x - me.x;
-    double dy = players[nearest].y - me.y;
+    double dx = world.players[nearest].x - me.x;
+    double dy = world.players[nearest].y - me.y;
 
     // normalize and place arrow near viewport edge
     double len = sqrt(dx*dx + dy*dy);
@@ -339,12 +345,13 @@ static void draw_nearest_arrow(int follow_idx) {
     // arrow position: push toward edge of screen
     int margin = 3;
     int ax = SW/2 + (int)(dx * (SW/2 - margin));
-    int ay = SH/2 + (int)(dy * (SH/2 - margin));
+    int ay = cv->h/2 + (int)(dy * (cv->h/2 - margin));
     // clamp
     if (ax < margin) ax = margin;
     if (ax >= SW-margin) ax = SW-margin-1;
     if (ay < 1) ay = 1;
-    if (ay >= SH-1) ay = SH-1;
+    if (ay >= cv->h-1) ay = cv->h-1;
+    ay += cv->top;
 
     // pick arrow character
     const char* arrow;
@@ -358,9 +365,92 @@ static void draw_nearest_arrow(int follow_idx) {
     else if (angle > -1.96 && angle <= -1.18) arrow = "↑";
     else                                       arrow = "↗";
 
-    attron(COLOR_PAIR(CP_TRAIL(players[nearest].slot->color)) | A_BOLD);
+    attron(COLOR_PAIR(CP_TRAIL(world.players[nearest].slot->color)) | A_BOLD);
     mvaddstr(ay, ax, arrow);
-    attroff(COLOR_PAIR(CP_TRAIL(players[nearest].slot->color)) | A_BOLD);
+    attroff(COLOR_PAIR(CP_TRAIL(world.players[nearest].slot->color)) | A_BOLD);
+    view_touch(ay, ax);
+}
+
+// corner overview of the whole world, drawn from the per-block counters
+static void draw_minimap() {
+    const Sim::World& w = world;
+    if (!show_minimap || !w.blk_w || Quality::level() >= Quality::BUDGET) return;
+    int ox = SW - w.blk_w - 2, oy = cv->top;
+    if (ox < 0) return;
+    for (int y=oy; y<oy+w.blk_h+2; y++)
+        for (int x=ox; x<ox+w.blk_w+2; x++) view_touch(y, x);
+    attron(COLOR_PAIR(CP_WALL) | A_DIM);
+    mvaddstr(oy, ox, "╭"); mvaddstr(oy, ox+w.blk_w+1, "╮");
+    mvaddstr(oy+w.blk_h+1, ox, "╰"); mvaddstr(oy+w.blk_h+1, ox+w.blk_w+1, "╯");
+    for (int i=1; i<=w.blk_w; i++) { mvaddstr(oy, ox+i, "─"); mvaddstr(oy+w.blk_h+1, ox+i, "─"); }
+    for (int i=1; i<=w.blk_h; i++) { mvaddstr(oy+i, ox, "│"); mvaddstr(oy+i, ox+w.blk_w+1, "│"); }
+    attroff(COLOR_PAIR(CP_WALL) | A_DIM);
+
+    int area = w.blk_bw * w.blk_bh;
+    for (int by=0; by<w.blk_h; by++) {
+        bool row_in = (by+1)*w.blk_bh > cv->cam_y && by*w.blk_bh < cv->cam_y + cv->h;
+        for (int bx=0; bx<w.blk_w; bx++) {
+            int b = by*w.blk_w + bx;
+            int sx = ox+1+bx, sy = oy+1+by;
+            bool in_cam = row_in && (bx+1)*w.blk_bw > cv->cam_x && bx*w.blk_bw < cv->cam_x + SW;
+            uint32_t fill = w.blk_fill[b];
+            if (!fill) {
+                attron(COLOR_PAIR(CP_DIM) | A_DIM);
+                mvaddstr(sy, sx, in_cam ? "·" : " ");
+                attroff(COLOR_PAIR(CP_DIM) | A_DIM);
+                continue;
+            }
+            const uint32_t* cnt = &w.blk_count[b*PC_COUNT];
+            int dom = 0;
+            for (int c=1; c<PC_COUNT; c++) if (cnt[c] > cnt[dom]) dom = c;
+            const char* ch = fill*20 < (uint32_t)area ? "░" :
+                             fill*7  < (uint32_t)area ? "▒" :
+                             fill*3  < (uint32_t)area ? "▓" : "█";
+            int attr = COLOR_PAIR(CP_TRAIL(dom)) | (in_cam ? A_BOLD : 0);
+            attron(attr); mvaddstr(sy, sx, ch); attroff(attr);
+        }
+    }
+    for (int i=0; i<w.num_players; i++) {
+        const Player& p = w.players[i];
+        if (!p.alive || !p.active) continue;
+        attron(COLOR_PAIR(CP_TRAIL(p.slot->color)) | A_BOLD);
+        mvaddstr(oy+1 + p.y/w.blk_bh, ox+1 + p.x/w.blk_bw, "●");
+        attroff(COLOR_PAIR(CP_TRAIL(p.slot->color)) | A_BOLD);
+    }
+}
+
+// low-power mode bookkeeping
+constexpr int KEY_FOCUS_IN  = KEY_F(61); // xterm focus reports, mapped via define_key
+constexpr int KEY_FOCUS_OUT = KEY_F(62);
+static bool   term_focused = true;
+static double lp_cpu = -1;  // average CPU % since the run started, -1 = not measuring
+
+// once every human in a fixed mode is out, the rest can be watched at 8x
+static bool fast_fwd = false;
+static const int FAST_FWD = 8;
+
+// ./tron watch: the world is a replica of another process's game
+static bool watching = false;
+
+static bool humans_out(GameMode mode) {
+    if (mode == MODE_ENDLESS || mode == MODE_AUTO || watching) return false;
+    return world.humans && !world.humans_alive;
+}
+
+double Game::cpu_percent() { return lp_cpu; }
+
+// bytes handed to the tty that the terminal hasn't read yet
+static int output_backlog() {
+    int n = 0;
+    if (ioctl(STDOUT_FILENO, TIOCOUTQ, &n) != 0) return 0;
+    return n;
+}
+
+static double cpu_seconds() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec/1e6
+         + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec/1e6;
 }
 
 static void draw_hud(GameMode mode, int follow_idx) {
@@ -369,27 +459,49 @@ static void draw_hud(GameMode mode, int follow_idx) {
     int x = 1;
 
     // in camera auto mode, show who we're following
-    if (use_camera && mode == MODE_AUTO && follow_idx >= 0) {
+    if (use_camera && (mode == MODE_AUTO || watching) && follow_idx >= 0) {
         char fbuf[32];
-        snprintf(fbuf, 32, "[watching AI%d] ", follow_idx+1);
-        attron(COLOR_PAIR(CP_TRAIL(players[follow_idx].slot->color)) | A_DIM);
+        snprintf(fbuf, 32, "[watching %s%d] ", world.players[follow_idx].slot->human ? "P" : "AI",
+                 follow_idx+1);
+        attron(COLOR_PAIR(CP_TRAIL(world.players[follow_idx].slot->color)) | A_DIM);
         mvaddstr(hud_y, x, fbuf);
-        attroff(COLOR_PAIR(CP_TRAIL(players[follow_idx].slot->color)) | A_DIM);
+        attroff(COLOR_PAIR(CP_TRAIL(world.players[follow_idx].slot->color)) | A_DIM);
         x += strlen(fbuf);
     }
 
-    for (int i=0; i<num_players; i++) {
-        char buf[16];
-        const char* type = players[i].slot->human ? "P" : "AI";
-        const char* status = players[i].alive ? "●" :
-                             players[i].active ? "~" : "✕";
-        snprintf(buf, 16, "%s%d%s", type, i+1, status);
-        int pair = CP_TRAIL(players[i].slot->color);
-        attron(COLOR_PAIR(pair) | (players[i].alive ? A_BOLD : A_DIM));
+    // big crowds: the humans get their own entry, the bots one summary
+    int listed = world.num_players > 8 ? 0 : world.num_players;
+    if (!listed) {
+        int bots = 0, alive = 0;
+        for (int i=0; i<world.num_players; i++) {
+            if (world.players[i].slot->human) continue;
+            bots++;
+            if (world.players[i].alive) alive++;
+        }
+        char buf[32];
+        snprintf(buf, 32, "AI %d/%d● ", alive, bots);
+        attron(COLOR_PAIR(CP_HUD) | A_BOLD);
         mvaddstr(hud_y, x, buf);
-        attroff(COLOR_PAIR(pair) | (players[i].alive ? A_BOLD : A_DIM));
+        attroff(COLOR_PAIR(CP_HUD) | A_BOLD);
+        x += strlen(buf) - 2; // ● is one column, three bytes
+    }
+    for (int i=0; i<world.num_players; i++) {
+        if (i >= listed && !world.players[i].slot->human) continue;
+        char buf[24];
+        const char* type = world.players[i].slot->human ? "P" : "AI";
+        const char* status = world.players[i].alive ? "●" :
+                             world.players[i].active ? "~" : "✕";
+        // humans: a > per boost left
+        int boosts = world.players[i].slot->human && world.players[i].alive ? world.players[i].boost_left : 0;
+        snprintf(buf, 24, "%s%d%s%.*s", type, i+1, status, std::min(boosts, 8), ">>>>>>>>");
+        int pair = CP_TRAIL(world.players[i].slot->color);
+        attron(COLOR_PAIR(pair) | (world.players[i].alive ? A_BOLD : A_DIM));
+        mvaddstr(hud_y, x, buf);
+        attroff(COLOR_PAIR(pair) | (world.players[i].alive ? A_BOLD : A_DIM));
         x += strlen(buf) + 1;
-        if (mode==MODE_2V2 && i==1) {
+        bool team_end = mode_teams(mode) && i+1 < world.num_players &&
+                        world.players[i+1].team != world.players[i].team;
+        if (team_end) {
             attron(COLOR_PAIR(CP_DIM));
             mvaddstr(hud_y, x, "vs ");
             attroff(COLOR_PAIR(CP_DIM));
@@ -397,144 +509,119 @@ static void draw_hud(GameMode mode, int follow_idx) {
         }
     }
     attron(COLOR_PAIR(CP_DIM));
-    if (mode==MODE_AUTO) mvaddstr(hud_y, x+1, "[Q]uit");
-    else                 mvaddstr(hud_y, x+1, "[Q]uit [R]estart");
-    attroff(COLOR_PAIR(CP_DIM));
-}
-
-static void ai_think(Player& p, GameMode mode) {
-    if (!p.alive || !p.active || p.slot->human) return;
-    int team = p.slot->team;
-    int look, inertia, aggression;
-    if (mode == MODE_AUTO) {
-        look = 20; inertia = 30; aggression = 40;
-    } else {
-        look    = (p.slot->diff==AI_EASY) ? 2 : (p.slot->diff==AI_MED) ? 5 : 12;
-        inertia = (p.slot->diff==AI_EASY) ? 85 : (p.slot->diff==AI_MED) ? 70 : 50;
-        aggression = (p.slot->diff==AI_EASY) ? 5 : (p.slot->diff==AI_MED) ? 15 : 30;
+    const char* keys = watching ? "[Q]uit [N]ext bike [G]ame's camera [M]ap"
+                     : mode==MODE_AUTO ? (use_camera ? "[Q]uit [Z]suspend [M]ap" : "[Q]uit [Z]suspend")
+                     : mode==MODE_ENDLESS ? "[Q]uit [R]estart [Z]suspend [M]ap"
+                                          : (use_camera ? "[Q]uit [R]estart [M]ap" : "[Q]uit [R]estart");
+    mvaddstr(hud_y, x+1, keys);
+    x += strlen(keys) + 2;
+    // the link can't keep up: how far the view has stepped down
+    const char* q = use_camera ? Quality::name() : "";
+    if (*q) mvaddstr(hud_y, SW - (int)strlen(q) - 1 - (lp_cpu >= 0 ? 14 : 0), q);
+    if (humans_out(mode)) {
+        mvaddstr(hud_y, x, fast_fwd ? "[F] normal speed" : "[F]ast-forward");
+        x += fast_fwd ? 17 : 15;
     }
-    bool do_perp = (p.slot->diff == AI_HARD || mode == MODE_AUTO);
-
-    // current direction safe?
-    int nx = p.x+dir_dx(p.dir), ny = p.y+dir_dy(p.dir);
-    if (!blocked_for(nx,ny,team,mode) && (rand()%100 < inertia)) return;
-
-    // find nearest other alive player
-    int target_x = -1, target_y = -1;
-    double nearest_dist = 1e9;
-    for (int i=0; i<num_players; i++) {
-        if (&players[i] == &p || !players[i].alive || !players[i].active) continue;
-        double dx = players[i].x - p.x;
-        double dy = players[i].y - p.y;
-        double d = dx*dx + dy*dy;
-        if (d < nearest_dist) { nearest_dist = d; target_x = players[i].x; target_y = players[i].y; }
-    }
-
-    // evaluate each direction
-    Dir best = p.dir;
-    int best_score = -99999;
-    for (int d=0; d<4; d++) {
-        Dir dd = (Dir)d;
-        if (dd == dir_opposite(p.dir)) continue;
-
-        // space check (survival)
-        int cx=p.x, cy=p.y, space=0;
-        for (int s=0; s<look; s++) {
-            cx+=dir_dx(dd); cy+=dir_dy(dd);
-            if (blocked_for(cx,cy,team,mode)) break;
-            space++;
-        }
-        if (do_perp && space > 0) {
-            int cx2=p.x+dir_dx(dd), cy2=p.y+dir_dy(dd);
-            for (int sd=0; sd<4; sd++) {
-                Dir perp=(Dir)sd;
-                if (perp==dd||perp==dir_opposite(dd)) continue;
-                int px=cx2, py=cy2;
-                for (int s=0;s<look/2;s++) {
-                    px+=dir_dx(perp); py+=dir_dy(perp);
-                    if (blocked_for(px,py,team,mode)) break;
-                    space++;
-                }
-            }
-        }
-
-        // dead end = never go there
-        if (space == 0) continue;
-
-        // aggression bonus: prefer directions that move toward target
-        int seek_bonus = 0;
-        if (target_x >= 0 && rand()%100 < aggression) {
-            int step_x = p.x + dir_dx(dd);
-            int step_y = p.y + dir_dy(dd);
-            double old_dist = (p.x-target_x)*(p.x-target_x) + (p.y-target_y)*(p.y-target_y);
-            double new_dist = (step_x-target_x)*(step_x-target_x) + (step_y-target_y)*(step_y-target_y);
-            if (new_dist < old_dist) seek_bonus = 8;
-        }
-
-        int score = space + seek_bonus;
-        if (score > best_score) { best_score = score; best = dd; }
+    // every bike walled into its own pocket: the result is all but decided
+    if (world.sealed && world.outcome == Sim::ONGOING) mvaddstr(hud_y, x, "sealed");
+    if (lp_cpu >= 0) {
+        char cbuf[24];
+        snprintf(cbuf, sizeof(cbuf), "cpu %.2f%%", lp_cpu);
+        mvaddstr(hud_y, SW - (int)strlen(cbuf) - 1, cbuf);
     }
-    p.dir = best;
-}
-
-static void move_player(Player& p, GameMode mode) {
-    if (!p.alive || !p.active) return;
-    int nx = p.x + dir_dx(p.dir);
-    int ny = p.y + dir_dy(p.dir);
-    if (blocked_for(nx, ny, p.slot->team, mode)) { p.alive=false; return; }
-
-    Dir old_dir = prev_dir[idx(p.x, p.y)];
-    // cache the corner glyph at the old position (same calc as draw_trail_seg)
-    int ox = p.x, oy = p.y;
-    if (ox>0 && ox<GW-1 && oy>0 && oy<GH-1)
-        trail_glyph[idx(ox,oy)] = corner_glyph(old_dir, p.dir);
-
-    p.x = nx; p.y = ny;
-    grid[idx(nx,ny)] = p.cell;
-    prev_dir[idx(nx,ny)] = p.dir;
-    trail_glyph[idx(nx,ny)] = TG_HD; // head marker (will be overwritten next move)
-    p.trail_cells.push_back({nx,ny});
-    // incremental draw only for fixed camera
-    if (!use_camera) draw_trail_seg(p, old_dir);
+    attroff(COLOR_PAIR(CP_DIM));
 }
-
 static int handle_input(GameMode mode) {
     int ch = getch();
+    while (ch == Quality::KEY_PONG) { Quality::pong(); ch = getch(); }
+    Latency::polled();
     if (ch == ERR) return 0;
     if (ch=='q'||ch=='Q') return -1;
     if ((ch=='r'||ch=='R') && mode!=MODE_AUTO) return 1;
-    for (int i=0; i<num_players; i++) {
-        if (!players[i].slot->human || !players[i].alive || !players[i].active) continue;
-        const KeySet& ks = keysets()[players[i].slot->keyset];
+    if ((ch=='z'||ch=='Z') && (mode==MODE_ENDLESS || mode==MODE_AUTO)) return 2;
+    if (ch=='m'||ch=='M') { show_minimap = !show_minimap; return 0; }
+    if ((ch=='f'||ch=='F') && humans_out(mode)) { fast_fwd = !fast_fwd; return 0; }
+    if (ch==KEY_FOCUS_IN)  { term_focused = true;  return 0; }
+    if (ch==KEY_FOCUS_OUT) { term_focused = false; return 0; }
+    for (int i=0; i<world.num_players; i++) {
+        if (!world.players[i].slot->human || !world.players[i].alive || !world.players[i].active) continue;
+        const KeySet& ks = keysets()[world.players[i].slot->keyset];
+        if (ch==ks.boost) { Sim::boost(world, i); continue; }
         Dir nd = D_NONE;
         if (ch==ks.up) nd=D_UP;
         if (ch==ks.down) nd=D_DOWN;
         if (ch==ks.left) nd=D_LEFT;
         if (ch==ks.right) nd=D_RIGHT;
-        if (nd!=D_NONE && nd!=dir_opposite(players[i].dir))
-            players[i].dir = nd;
+        if (nd!=D_NONE && nd!=dir_opposite(world.players[i].dir)) {
+            world.players[i].dir = nd;
+            Latency::key(i);
+        }
     }
     return 0;
 }
 
-static void countdown_cam(int follow_idx) {
-    // camera mode countdown: render viewport centered on follow target
+// glyph set the views were drawn in, so a switch repaints them
+static bool drawn_ascii = false;
+
+// one camera-mode frame: each view centered on its target, then its overlays.
+// on a budget (Quality) the minimap and the dead-trail flash are left out.
+static void draw_cam_frame(GameMode mode, int tick, int flash_ticks, int flash_toggle) {
+    bool lean = Quality::level() >= Quality::BUDGET;
+    if (Quality::ascii() != drawn_ascii) {
+        drawn_ascii = !drawn_ascii;
+        for (int v=0; v<num_views; v++) std::fill(views[v].shadow.begin(), views[v].shadow.end(), SHADOW_DIRTY);
+    }
+    for (int v=0; v<num_views; v++) {
+        cv = &views[v];
+        follow_cam(*cv, world.players[cv->follow].x, world.players[cv->follow].y);
+        render_viewport(*cv);
+
+        // draw heads on top of viewport
+        for (int i=0;i<world.num_players;i++)
+            if (world.players[i].alive && world.players[i].active)
+                draw_head_at(world.players[i]);
+
+        // flash dead trails
+        for (int i=0; i<world.num_players && !lean; i++) {
+            Player& p = world.players[i];
+            if (!p.alive && p.active && p.death_tick >= 0) {
+                int since = tick - p.death_tick;
+                if (since <= flash_ticks) {
+                    bool bright = ((since / flash_toggle) % 2) == 0;
+                    flash_trail(p, bright);
+                }
+            }
+        }
+
+        // proximity arrow in endless
+        if (mode == MODE_ENDLESS)
+            draw_nearest_arrow(cv->follow);
+        draw_minimap();
+    }
+    if (num_views == 2) {
+        int dy = views[0].top + views[0].h;
+        attron(COLOR_PAIR(CP_WALL) | A_DIM);
+        for (int x=0; x<SW; x++) mvaddstr(dy, x, drawn_ascii ? "=" : "═");
+        attroff(COLOR_PAIR(CP_WALL) | A_DIM);
+    }
+}
+
+static void countdown_cam(GameMode mode, int follow_idx) {
+    // camera mode countdown: render each view centered on its target
     for (int i=3; i>0; i--) {
-        if (follow_idx >= 0) center_cam(players[follow_idx].x, players[follow_idx].y);
-        render_viewport();
-        // draw all heads
-        for (int p=0;p<num_players;p++)
-            if (players[p].active) draw_head_at(players[p]);
+        draw_cam_frame(mode, 0, 0, 1);
         char buf[4]; snprintf(buf,4," %d ",i);
         attron(COLOR_PAIR(CP_HUD)|A_BOLD);
         mvaddstr(SH/2, SW/2-1, buf);
         attroff(COLOR_PAIR(CP_HUD)|A_BOLD);
-        draw_hud(MODE_ENDLESS, follow_idx);
+        for (int k=0; k<3; k++) view_touch(SH/2, SW/2-1+k);
+        draw_hud(mode, follow_idx);
         refresh(); napms(600);
     }
     attron(COLOR_PAIR(CP_HUD)|A_BOLD);
     mvaddstr(SH/2, SW/2-2, " GO! ");
     attroff(COLOR_PAIR(CP_HUD)|A_BOLD);
+    for (int k=0; k<5; k++) view_touch(SH/2, SW/2-2+k);
     refresh(); napms(300);
 }
 
@@ -568,8 +655,92 @@ static void show_result(const char* msg) {
     refresh();
 }
 
+// autotron camera: follow the longest trail, switch if the target died
+static void update_follow() {
+    int& f = views[0].follow;
+    if (!world.players[f].alive || !world.players[f].active) { f = find_follow_target(); return; }
+    // switch if the leader's trail is well ahead
+    int lead = Sim::longest_trail(world);
+    if (world.players[lead].trail.size() > world.players[f].trail.size() + 20) f = lead;
+}
+
+// level-of-detail ai: bikes the cameras show (plus a margin) get full thinks
+static void lod_focus() {
+    world.num_focus = num_views;
+    int m = world.lod_near;
+    for (int v=0; v<num_views; v++)
+        world.focus[v] = {views[v].cam_x - m, views[v].cam_y - m,
+                          views[v].cam_x + SW + m, views[v].cam_y + views[v].h + m};
+}
+
+// --events: round counter, and what each view followed last
+static int ev_round = 0;
+static int ev_follow[2];
+
+// pass the sim's bike events and any camera switch on to the event stream
+static void flush_events() {
+    for (const Sim::Event& e : world.events)
+        Events::emit({(Events::Kind)(Events::SPAWN + e.kind), e.dir, e.player, e.x, e.y, e.by, 0,
+                      ev_round, world.tick, 0});
+    world.events.clear();
+    for (int v=0; v<num_views; v++) {
+        if (views[v].follow == ev_follow[v]) continue;
+        ev_follow[v] = views[v].follow;
+        Events::emit({Events::CAMERA, D_NONE, (int16_t)v, 0, 0, (int16_t)ev_follow[v], 0,
+                      ev_round, world.tick, 0});
+    }
+}
+
+static void emit_round_end(int outcome, int winner) {
+    if (!Events::enabled()) return;
+    flush_events();
+    Events::emit({Events::ROUND_END, D_NONE, -1, 0, 0, (int16_t)outcome, (int16_t)winner,
+                  ev_round, world.tick, 0});
+}
+
+// per-tick drawing, picked once per round
+static void after_tick_cam(GameMode mode, bool show, int flash_toggle) {
+    // endless always follows the human(s)
+    if (mode == MODE_AUTO) update_follow();
+    if (show) draw_cam_frame(mode, world.tick, world.flash_ticks, flash_toggle);
+    if (world.lod) lod_focus();
+}
+
+static void after_tick_fixed(GameMode mode, bool, int flash_toggle) {
+    draw_dirty();
+    if (mode != MODE_AUTO) return; // only respawning modes flash their dead
+    for (int i=0;i<world.num_players;i++) {
+        Player& p = world.players[i];
+        if (p.alive || !p.active || p.death_tick < 0) continue;
+        int since = world.tick - p.death_tick;
+        if (since <= world.flash_ticks)
+            flash_trail(p, ((since / flash_toggle) % 2) == 0);
+    }
+}
+
+// seconds since t0 on the monotonic clock
+static double since(const struct timespec& t0) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec-t0.tv_sec)+(now.tv_nsec-t0.tv_nsec)/1e9;
+}
+
+// the match as it stands, for ./tron resume
+static bool suspend_match(GameMode mode, uint32_t seed, Arena::Kind gen, bool map_file,
+                          double elapsed, const std::vector<Slot>& roster) {
+    Snapshot::Meta m;
+    m.mode = mode;
+    m.gw = GW; m.gh = GH;
+    m.use_camera = use_camera;
+    m.arena_kind = map_file ? Arena::OPEN : gen;
+    m.seed = seed;
+    if (map_file) m.map_file = options.map_file;
+    m.elapsed = elapsed;
+    m.slots = roster;
+    return Snapshot::save(Snapshot::path(), world, m);
+}
+
 int Game::run(GameMode mode, Slot slots[8]) {
-    srand(time(nullptr));
     SW = COLS; SH = LINES - 1;
     if (SW<30 || SH<16) return -1;
 
@@ -579,7 +750,30 @@ int Game::run(GameMode mode, Slot slots[8]) {
     // endless always uses camera
     if (mode == MODE_ENDLESS) use_camera = true;
 
-    if (use_camera) {
+    // resuming: the snapshot decides size, camera, arena and roster
+    Snapshot::Meta resume;
+    bool resuming = !options.resume_file.empty() && Snapshot::peek(options.resume_file, resume) &&
+                    resume.mode == mode;
+    if (resuming) {
+        use_camera = resume.use_camera;
+        options.map_file = resume.map_file;
+    }
+
+    // a map file fixes the world size (and needs the camera if it won't fit);
+    // otherwise the configured generator fills whatever size the mode picked
+    bool map_file = !options.map_file.empty() && Arena::load(arena, options.map_file);
+    Arena::Kind gen = resuming ? (Arena::Kind)resume.arena_kind : (Arena::Kind)Config::get().arena;
+    if (resuming && (map_file ? arena.w != resume.gw || arena.h != resume.gh
+                              : gen < 0 || gen >= Arena::KIND_COUNT || !resume.map_file.empty()))
+        resuming = false; // the map it was played on has gone or changed
+    if (!resuming) gen = (Arena::Kind)Config::get().arena;
+    if (resuming) {
+        GW = resume.gw; GH = resume.gh;
+        if (GW > SW || GH > SH) use_camera = true;
+    } else if (map_file) {
+        GW = arena.w; GH = arena.h;
+        if (GW > SW || GH > SH) use_camera = true;
+    } else if (use_camera) {
         GW = SW * 3; GH = SH * 3; // 3x terminal size
         if (GW < 150) GW = 150;
         if (GH < 80)  GH = 80;
@@ -587,244 +781,281 @@ int Game::run(GameMode mode, Slot slots[8]) {
         GW = SW; GH = SH;
     }
 
-    grid = new Cell[GW*GH];
-    prev_dir = new Dir[GW*GH];
-    trail_glyph = new uint8_t[GW*GH];
-    int result = -1;
-    bool keep_playing = true;
-
-    bool respawning = (mode==MODE_ENDLESS || mode==MODE_AUTO);
+    // two humans in a camera mode = split-screen, one camera each
+    int humans = 0;
+    for (int i=0;i<mode_players(mode);i++) if (slots[i].human) humans++;
+    num_views = use_camera ? (humans >= 2 ? 2 : 1) : 0;
+    if (num_views == 1) {
+        views[0].top = 0; views[0].h = SH;
+    } else if (num_views == 2) {
+        views[0].top = 0; views[0].h = (SH-1)/2;
+        views[1].top = views[0].h + 1; // divider row in between
+        views[1].h = SH - views[1].top;
+    }
+    for (int v=0; v<num_views; v++) {
+        views[v].shadow.assign(SW*views[v].h, SHADOW_DIRTY);
+        views[v].drawn_x = views[v].drawn_y = -1;
+        views[v].framed = -1;
+        views[v].follow = 0;
+    }
+    cv = &views[0];
+    idlok(stdscr, use_camera); // let curses use the terminal's scrolling for camera moves
 
     int tick_ms = Config::get().tick_ms;
     int tick_us = tick_ms * 1000;
-    int flash_ticks   = 2000 / tick_ms;
-    int respawn_ticks = (mode==MODE_AUTO ? 3000 : 10000) / tick_ms;
     int flash_toggle  = 250 / tick_ms;
     if (flash_toggle < 1) flash_toggle = 1;
-    if (flash_ticks < 2) flash_ticks = 2;
-    if (respawn_ticks < flash_ticks + 2) respawn_ticks = flash_ticks + 2;
 
-    int follow_idx = 0;
+    // the slots, plus extra CPU bikes when a bigger crowd is configured
+    bool respawning = (mode==MODE_ENDLESS || mode==MODE_AUTO);
+    std::vector<Slot> roster(slots, slots + mode_players(mode));
+    if (resuming) {
+        roster = resume.slots;
+    } else if (respawning) {
+        AIDiff diff = AI_MED;
+        for (auto& s : roster) if (!s.human) { diff = s.diff; break; }
+        // the crowd cycles the colors no human rides, so a player's own
+        // bike is never mistaken for one of them
+        PColor crowd[PC_COUNT];
+        int ncrowd = 0;
+        for (int c=0; c<PC_COUNT; c++) {
+            bool ridden = false;
+            for (auto& s : roster) ridden |= s.human && s.color == c;
+            if (!ridden) crowd[ncrowd++] = (PColor)c;
+        }
+        while ((int)roster.size() < std::min(Config::get().crowd, Sim::MAX_PLAYERS))
+            roster.push_back({false, crowd[roster.size() % ncrowd], 0, diff, 0});
+    }
+
+    Sim::create(world, mode, GW, GH, tick_ms, Config::get().trail_len);
+    world.lod = respawning && use_camera;
+    world.mixed_speeds = Config::get().speeds;
+    world.map = (map_file || gen != Arena::OPEN) ? &arena : nullptr;
+    mm_init();
+    world.track_dirty = !use_camera || Spectate::publishing(); // spectators get the changed cells too
+    world.track_events = Events::enabled();
+    auto after_tick = use_camera ? after_tick_cam : after_tick_fixed;
+    int result = -1;
+    bool keep_playing = true;
+
+    // low power: one frame (input poll, draw, sleep) every lp_every ticks,
+    // ~5 fps, with the sim ticks in between run back to back
+    bool lp = options.low_power && mode == MODE_AUTO;
+    int lp_every = lp ? std::max(1, 200 / tick_ms) : 1;
+    double lp_cpu0 = cpu_seconds();
+    struct timespec lp_t0, lp_deadline;
+    clock_gettime(CLOCK_MONOTONIC, &lp_t0);
+    lp_deadline = lp_t0;
+    lp_cpu = -1;
+    Quality::reset();
+    drawn_ascii = false;
+    term_focused = true;
+    if (lp) {
+        define_key("\033[I", KEY_FOCUS_IN);
+        define_key("\033[O", KEY_FOCUS_OUT);
+        putp("\033[?1004h"); // ask the terminal for focus in/out reports
+    }
+
+    // respawning modes can be suspended (Z) and are autosaved now and then,
+    // so a crash costs at most a minute of a long session. autosaves never
+    // overwrite a snapshot some other match left behind.
+    const double AUTOSAVE_S = 60;
+    std::string snap = Snapshot::path();
 
     while (keep_playing) {
-        grid_init();
-        if (respawning) {
-            num_players = mode_players(mode);
-            for (int i=0; i<num_players; i++) {
-                players[i].slot = &slots[i];
-                players[i].cell = (Cell)(C_P1+i);
-                players[i].index = i;
-                spawn_player(players[i]);
-            }
+        // per-round seed so the history log can name the round that was played
+        struct timespec seed_ts;
+        clock_gettime(CLOCK_REALTIME, &seed_ts);
+        uint32_t seed = (uint32_t)(seed_ts.tv_sec * 1000003u) ^ (uint32_t)seed_ts.tv_nsec;
+        double resumed_s = 0;
+        if (resuming) seed = resume.seed;
+        if (!map_file && gen != Arena::OPEN) Arena::generate(arena, gen, GW, GH, seed);
+        if (resuming && Snapshot::load(options.resume_file, world, roster.data())) {
+            resumed_s = resume.elapsed;
+            unlink(options.resume_file.c_str()); // carried on; don't resume it twice
         } else {
-            spawn_players_fixed(mode, slots);
+            Sim::start_round(world, roster.data(), (int)roster.size(), seed);
         }
+        resuming = false;
+        bool autosave = respawning && access(snap.c_str(), F_OK) != 0;
 
-        // find initial follow target
+        // find initial follow targets
         if (use_camera) {
             if (mode == MODE_ENDLESS) {
-                // follow the human
-                for (int i=0;i<num_players;i++)
-                    if (players[i].slot->human) { follow_idx=i; break; }
+                // each view follows its own human
+                int v = 0;
+                for (int i=0;i<world.num_players && v<num_views;i++)
+                    if (world.players[i].slot->human) views[v++].follow = i;
             } else {
-                follow_idx = find_follow_target();
+                views[0].follow = find_follow_target();
             }
-            center_cam(players[follow_idx].x, players[follow_idx].y);
+        }
+        Spectate::round(world, views[0].follow, tick_ms);
+        if (world.track_events) {
+            ev_round++;
+            Events::emit({Events::ROUND_START, D_NONE, -1, (int16_t)GW, (int16_t)GH, (int16_t)mode,
+                          (int16_t)world.num_players, ev_round, 0, seed});
+            ev_follow[0] = ev_follow[1] = -1;
+            flush_events();
         }
 
+        if (use_camera) Quality::pause();
         erase();
         if (use_camera) {
-            render_viewport();
-            for (int i=0;i<num_players;i++)
-                if (players[i].active) draw_head_at(players[i]);
+            world.dirty.clear();
+            views_invalidate();
+            draw_cam_frame(mode, 0, 0, 1);
+            if (world.lod) lod_focus();
         } else {
-            draw_border();
-            for (int i=0;i<num_players;i++)
-                if (players[i].active) draw_head_at(players[i]);
+            draw_walls();
+            world.dirty.clear();
+            for (int i=0;i<world.num_players;i++)
+                if (world.players[i].active) draw_head_at(world.players[i]);
         }
 
         // pre-game labels
-        for (int i=0;i<num_players;i++)
-            if (wants_label(players[i], mode)) draw_label(players[i]);
-        draw_hud(mode, follow_idx); refresh();
+        for (int v=0; v<(use_camera ? num_views : 1); v++) {
+            cv = &views[v];
+            for (int i=0;i<world.num_players;i++)
+                if (wants_label(world.players[i], mode)) draw_label(world.players[i]);
+        }
+        draw_hud(mode, views[0].follow); refresh();
 
         if (mode != MODE_AUTO) {
             if (use_camera)
-                countdown_cam(follow_idx);
+                countdown_cam(mode, views[0].follow);
             else
                 countdown_fixed();
             // erase labels
-            for (int i=0;i<num_players;i++)
-                if (wants_label(players[i], mode)) erase_label(players[i]);
-            for (int i=0;i<num_players;i++)
-                if (players[i].active) draw_head_at(players[i]);
+            for (int v=0; v<(use_camera ? num_views : 1); v++) {
+                cv = &views[v];
+                for (int i=0;i<world.num_players;i++)
+                    if (wants_label(world.players[i], mode)) erase_label(world.players[i]);
+                for (int i=0;i<world.num_players;i++)
+                    if (world.players[i].active) draw_head_at(world.players[i]);
+            }
             refresh();
         }
         timeout(0);
 
-        struct timespec start;
+        struct timespec start, last_save;
         clock_gettime(CLOCK_MONOTONIC, &start);
+        last_save = start;
+        // time already played before a suspend counts toward this round
+        start.tv_sec -= (time_t)resumed_s;
+        start.tv_nsec -= (long)((resumed_s - (time_t)resumed_s) * 1e9);
+        if (start.tv_nsec < 0) { start.tv_sec--; start.tv_nsec += 1000000000L; }
         bool round_over = false;
-        int tick = 1;
+        fast_fwd = false;
+        Latency::drop();
 
         while (!round_over) {
-            int inp = handle_input(mode);
-            if (inp == -1) { keep_playing=false; break; }
-            if (inp == 1 && mode!=MODE_AUTO) break;
-
-            // move
-            for (int i=0;i<num_players;i++) ai_think(players[i], mode);
-            for (int i=0;i<num_players;i++) move_player(players[i], mode);
-
-            // mark newly dead
-            for (int i=0;i<num_players;i++) {
-                Player& p = players[i];
-                if (!p.alive && p.active && p.death_tick < 0)
-                    p.death_tick = tick;
+            bool frame = (world.tick+1) % lp_every == 0;
+            // don't draw what the terminal can't show right now
+            bool show = frame && (!lp || (term_focused && output_backlog() == 0)) &&
+                        !(use_camera && Quality::skip());
+            int inp = frame ? handle_input(mode) : 0;
+            if (inp == -1) { keep_playing=false; emit_round_end(Sim::ONGOING, -1); if (autosave) unlink(snap.c_str()); break; }
+            if (inp == 2 && suspend_match(mode, seed, gen, map_file, since(start), roster)) {
+                keep_playing=false; emit_round_end(Sim::ONGOING, -1); break;
             }
-
-            // respawn processing
-            if (respawning) {
-                for (int i=0;i<num_players;i++) {
-                    Player& p = players[i];
-                    if (p.alive) continue;
-                    if (p.death_tick < 0) continue;
-                    int since = tick - p.death_tick;
-
-                    if (p.active) {
-                        if (since <= flash_ticks) {
-                            if (!use_camera) {
-                                bool bright = ((since / flash_toggle) % 2) == 0;
-                                flash_trail(p, bright);
-                            }
-                            // camera mode: flash handled in render_viewport below
-                        } else {
-                            erase_trail(p);
-                            p.active = false;
-                        }
-                    } else {
-                        if (since >= respawn_ticks) {
-                            if (mode==MODE_ENDLESS && p.slot->human) {
-                                // human stays dead
-                            } else {
-                                spawn_player(p);
-                            }
-                        }
-                    }
-                }
+            if (inp == 1 && mode!=MODE_AUTO) { emit_round_end(Sim::ONGOING, -1); if (autosave) unlink(snap.c_str()); break; }
+
+            Sim::tick(world);
+            if (Latency::enabled())
+                for (int i=0; i<std::min(world.num_players, 8); i++)
+                    if (slots[i].human && world.players[i].alive) Latency::moved(i);
+            if (Spectate::publishing()) {
+                Spectate::tick(world, views[0].follow);
+                if (use_camera) world.dirty.clear(); // the fixed view draws from it below
             }
-
-            // update camera
-            if (use_camera) {
-                if (mode == MODE_AUTO) {
-                    // follow longest trail, switch if current target died
-                    if (!players[follow_idx].alive || !players[follow_idx].active)
-                        follow_idx = find_follow_target();
-                    else {
-                        // check if someone else has a longer trail
-                        int cur_len = (int)players[follow_idx].trail_cells.size();
-                        for (int i=0;i<num_players;i++) {
-                            if (!players[i].alive) continue;
-                            if ((int)players[i].trail_cells.size() > cur_len + 20) {
-                                follow_idx = i; break;
-                            }
-                        }
-                    }
-                }
-                // endless always follows the human
-                center_cam(players[follow_idx].x, players[follow_idx].y);
-                render_viewport();
-
-                // draw heads on top of viewport
-                for (int i=0;i<num_players;i++)
-                    if (players[i].alive && players[i].active)
-                        draw_head_at(players[i]);
-
-                // flash dead trails in camera mode
-                if (respawning) {
-                    for (int i=0;i<num_players;i++) {
-                        Player& p = players[i];
-                        if (!p.alive && p.active && p.death_tick >= 0) {
-                            int since = tick - p.death_tick;
-                            if (since <= flash_ticks) {
-                                bool bright = ((since / flash_toggle) % 2) == 0;
-                                flash_trail(p, bright);
-                            }
-                        }
-                    }
-                }
-
-                // proximity arrow in endless
-                if (mode == MODE_ENDLESS)
-                    draw_nearest_arrow(follow_idx);
+            after_tick(mode, show, flash_toggle);
+            if (world.track_events) flush_events();
+            if (autosave && since(last_save) >= AUTOSAVE_S) {
+                suspend_match(mode, seed, gen, map_file, since(start), roster);
+                clock_gettime(CLOCK_MONOTONIC, &last_save);
             }
 
-            // win conditions
-            if (mode==MODE_ENDLESS) {
-                for (int i=0;i<num_players;i++) {
-                    if (players[i].slot->human && !players[i].alive && !round_over) {
-                        round_over = true;
-                        struct timespec now;
-                        clock_gettime(CLOCK_MONOTONIC, &now);
-                        double elapsed = (now.tv_sec-start.tv_sec)+(now.tv_nsec-start.tv_nsec)/1e9;
-                        char buf[48];
-                        snprintf(buf, 48, "  Survived %.1fs  ", elapsed);
-                        show_result(buf);
-                        result = -1;
-                    }
-                }
-            } else if (!respawning) {
-                int alive_count=0, last_alive=-1;
-                for (int i=0;i<num_players;i++)
-                    if (players[i].alive) { alive_count++; last_alive=i; }
-
-                if (mode==MODE_2V2) {
-                    bool t0=false, t1=false;
-                    for (int i=0;i<num_players;i++)
-                        if (players[i].alive) (slots[i].team==0?t0:t1)=true;
-                    if (!t0||!t1) {
-                        round_over = true;
-                        if (!t0&&!t1) { show_result("  DRAW!  "); result=-1; }
-                        else if (t0)  { show_result("  Team 1 wins!  "); result=0; }
-                        else          { show_result("  Team 2 wins!  "); result=2; }
-                    }
-                } else if (alive_count <= 1) {
-                    round_over = true;
-                    if (alive_count==0) { show_result("  DRAW!  "); result=-1; }
-                    else {
-                        char buf[32];
-                        snprintf(buf,32,"  %s %d wins!  ",
-                                 players[last_alive].slot->human?"Player":"CPU", last_alive+1);
-                        show_result(buf); result=last_alive;
-                    }
-                }
+            round_over = world.outcome != Sim::ONGOING;
+            if (round_over && autosave) unlink(snap.c_str());
+            if (round_over) emit_round_end(world.outcome, world.winner);
+            switch (world.outcome) {
+            case Sim::ONGOING:
+                break;
+            case Sim::HUMANS_OUT: {
+                double elapsed = since(start);
+                char buf[48];
+                snprintf(buf, 48, "  Survived %.1fs  ", elapsed);
+                show_result(buf);
+                result = -1;
+                break;
+            }
+            case Sim::DRAW:
+                show_result("  DRAW!  "); result = -1;
+                break;
+            case Sim::TEAM_WIN: {
+                result = world.winner;
+                char buf[32];
+                snprintf(buf,32,"  Team %d wins!  ", world.players[result].team+1);
+                show_result(buf);
+                break;
+            }
+            case Sim::WINNER: {
+                result = world.winner;
+                char buf[32];
+                snprintf(buf,32,"  %s %d wins!  ",
+                         world.players[result].slot->human?"Player":"CPU", result+1);
+                show_result(buf);
+                break;
+            }
             }
 
-            tick++;
-            draw_hud(mode, follow_idx); refresh();
-            usleep(tick_us);
+            if (lp && frame) {
+                struct timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                double wall = (now.tv_sec-lp_t0.tv_sec)+(now.tv_nsec-lp_t0.tv_nsec)/1e9;
+                if (wall > 0) lp_cpu = 100.0 * (cpu_seconds() - lp_cpu0) / wall;
+            }
+            if (show) {
+                draw_hud(mode, views[0].follow);
+                if (use_camera) Quality::flush(); else refresh();
+                Latency::shown();
+            }
+            if (!lp) {
+                usleep(fast_fwd ? tick_us / FAST_FWD : tick_us);
+            } else if (frame) {
+                // one absolute-deadline sleep per frame instead of one per tick
+                long ns = lp_deadline.tv_nsec + (long)lp_every * tick_ms * 1000000L;
+                lp_deadline.tv_sec += ns / 1000000000L;
+                lp_deadline.tv_nsec = ns % 1000000000L;
+                struct timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                if (now.tv_sec > lp_deadline.tv_sec ||
+                    (now.tv_sec == lp_deadline.tv_sec && now.tv_nsec > lp_deadline.tv_nsec))
+                    lp_deadline = now; // fell behind: don't try to catch up
+                else
+                    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &lp_deadline, nullptr);
+            }
         }
 
         if (!keep_playing) break;
 
         if (round_over) {
-            struct timespec end;
-            clock_gettime(CLOCK_MONOTONIC, &end);
-            double elapsed = (end.tv_sec-start.tv_sec)+(end.tv_nsec-start.tv_nsec)/1e9;
+            double elapsed = since(start);
             auto& sc = Config::scores();
+            bool human_won = (result>=0 && slots[result].human);
+            if (mode_teams(mode) && result>=0) {
+                int wt = world.players[result].team;
+                human_won = false;
+                for (int i=0;i<world.num_players;i++)
+                    if (world.players[i].team==wt && slots[i].human) human_won=true;
+            }
 
             if (mode==MODE_ENDLESS) {
                 sc.rounds_played++;
                 if (elapsed > sc.best_endless) sc.best_endless = elapsed;
             } else if (mode!=MODE_AUTO) {
                 sc.rounds_played++;
-                bool human_won = (result>=0 && slots[result].human);
-                if (mode==MODE_2V2 && result>=0) {
-                    int wt = slots[result].team;
-                    human_won = false;
-                    for (int i=0;i<num_players;i++)
-                        if (slots[i].team==wt && slots[i].human) human_won=true;
-                }
                 if (human_won) {
                     sc.total_wins++;
                     sc.current_streak++;
@@ -834,8 +1065,26 @@ int Game::run(GameMode mode, Slot slots[8]) {
             }
             Config::save_scores();
 
+            History::Match hm{};
+            hm.when      = time(nullptr);
+            hm.mode      = (uint8_t)mode;
+            hm.nslots    = (uint8_t)world.num_players; // per-slot fields cover the first 8
+            hm.winner    = (int8_t)result;
+            hm.human_won = human_won;
+            hm.diff      = 0xff;
+            hm.seed      = seed;
+            hm.duration  = (float)elapsed;
+            for (int i=0;i<std::min(world.num_players, 8);i++) {
+                if (slots[i].human) hm.human_mask |= 1u << i;
+                else if (hm.diff == 0xff || slots[i].diff > hm.diff) hm.diff = (uint8_t)slots[i].diff;
+                int d = world.players[i].death_tick;
+                hm.survival[i] = (uint32_t)(d >= 0 ? d : world.tick);
+            }
+            History::append(hm);
+
             if (mode == MODE_AUTO) continue;
 
+            if (use_camera) Quality::pause();
             timeout(-1);
             while (true) {
                 int ch = getch();
@@ -845,8 +1094,79 @@ int Game::run(GameMode mode, Slot slots[8]) {
         }
     }
 
-    delete[] grid;
-    delete[] prev_dir;
-    delete[] trail_glyph;
+    if (lp) putp("\033[?1004l");
+    if (use_camera) Quality::pause();
+    idlok(stdscr, FALSE);
     return result;
 }
+
+int Game::watch() {
+    SW = COLS; SH = LINES - 1;
+    if (SW<30 || SH<16) return -1;
+    watching = true;
+    use_camera = true;
+    num_views = 1;
+    views[0].top = 0; views[0].h = SH;
+    views[0].shadow.assign(SW*SH, SHADOW_DIRTY);
+    views[0].drawn_x = views[0].drawn_y = -1;
+    views[0].framed = -1;
+    views[0].follow = 0;
+    cv = &views[0];
+    idlok(stdscr, TRUE);
+    timeout(0);
+    Quality::reset();
+    drawn_ascii = false;
+
+    // our own camera: the game's target unless N picked a bike
+    static Slot wslots[Sim::MAX_PLAYERS];
+    int pinned = -1, game_follow = 0, tick_ms = 50;
+    bool attached = false;
+    while (true) {
+        int ch = getch();
+        while (ch == Quality::KEY_PONG) { Quality::pong(); ch = getch(); }
+        if (ch=='q'||ch=='Q') break;
+        if (ch=='m'||ch=='M') { show_minimap = !show_minimap; views_invalidate(); }
+        if ((ch=='g'||ch=='G') && pinned >= 0) { pinned = -1; views[0].framed = -1; }
+        if ((ch=='n'||ch=='N') && attached && world.num_players) {
+            int from = pinned >= 0 ? pinned : views[0].follow;
+            for (int k=1; k<=world.num_players; k++) {
+                int i = (from + k) % world.num_players;
+                if (world.players[i].alive) { pinned = i; break; }
+            }
+        }
+
+        if (!attached && !(attached = Spectate::attach())) {
+            const char* msg = "  waiting for a game started with --publish  ";
+            erase();
+            attron(COLOR_PAIR(CP_HUD)|A_BOLD);
+            mvaddstr(SH/2, std::max(0, (SW-(int)strlen(msg))/2), msg);
+            attroff(COLOR_PAIR(CP_HUD)|A_BOLD);
+            refresh();
+            views_invalidate();
+            napms(250);
+            continue;
+        }
+        Spectate::Sync r = Spectate::sync(world, wslots, game_follow, tick_ms);
+        if (r == Spectate::GONE) { Spectate::detach(); attached = false; pinned = -1; continue; }
+        if (r == Spectate::NEW_ROUND) {
+            GW = world.GW; GH = world.GH;
+            mm_init();
+            erase();
+            views_invalidate();
+            if (pinned >= world.num_players) pinned = -1;
+        }
+        if (r != Spectate::NOTHING && (r == Spectate::NEW_ROUND || !Quality::skip())) {
+            views[0].follow = pinned >= 0 ? pinned : game_follow;
+            draw_cam_frame(world.mode, world.tick, 0, 1);
+            draw_hud(world.mode, views[0].follow);
+            Quality::flush();
+        }
+        napms(std::clamp(tick_ms / 2, 5, 50)); // twice a tick: never a tick behind
+    }
+
+    Spectate::detach();
+    Quality::pause();
+    idlok(stdscr, FALSE);
+    watching = false;
+    return 0;
+}
@@ -2,6 +2,25 @@
 #include "types.h"
 
 namespace Game {
+    // command-line switches that outlive a single run
+    struct Options {
+        // screensaver budget: render slower than we simulate, skip frames the
+        // terminal can't show, batch sleeps
+        bool low_power = false;
+        // --map FILE: play on this arena instead of the configured one
+        std::string map_file;
+        // ./tron resume: carry on from this snapshot instead of a fresh round
+        std::string resume_file;
+    };
+    Options& opts();
+
     // standard modes: returns winner index or -1
     int run(GameMode mode, Slot slots[8]);
+
+    // ./tron watch: render the game another process publishes (--publish)
+    // until Q. returns -1 if the terminal is too small.
+    int watch();
+
+    // low-power runs: average CPU use of this process over the last run, in %
+    double cpu_percent();
 }
@@ -0,0 +1,247 @@
+#include "heatmap.h"
+#include "sim.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+// many all-CPU matches at once, one World per worker. each worker adds into
+// its own accumulators, and they are summed after the join. match k always
+// uses seed k, and sums of counts don't care about order, so the output is
+// the same on any number of cores.
+namespace {
+constexpr int GW = 150, GH = 80; // the smallest camera-mode world
+constexpr int NDIFF = 3;
+constexpr const char* diff_label[NDIFF] = {"easy", "medium", "hard"};
+// AutoTron tunes every bike the same whatever its slot says, so there it's
+// one class; only Endless has difficulties to tell apart
+constexpr const char* auto_label[1] = {"auto"};
+
+struct Acc {
+    std::vector<uint64_t> occ[NDIFF];    // head-ticks per cell, by difficulty
+    std::vector<uint64_t> deaths;        // crashes per cell (the head's last cell)
+    std::vector<uint64_t> spawns;        // lives started per cell
+    std::vector<uint64_t> spawn_done;    // ... of those, lives that ended
+    std::vector<uint64_t> spawn_life;    // their summed lifetime
+    std::vector<uint64_t> life[NDIFF];   // finished lives by length in ticks
+    uint64_t unfinished[NDIFF] = {};     // still going when the match ended
+
+    explicit Acc(long ticks) {
+        for (int d=0; d<NDIFF; d++) { occ[d].assign(GW*GH, 0); life[d].assign(ticks + 1, 0); }
+        deaths.assign(GW*GH, 0);
+        spawns.assign(GW*GH, 0);
+        spawn_done.assign(GW*GH, 0);
+        spawn_life.assign(GW*GH, 0);
+    }
+    void add(const Acc& o) {
+        auto sum = [](std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+            for (size_t i=0; i<a.size(); i++) a[i] += b[i];
+        };
+        for (int d=0; d<NDIFF; d++) { sum(occ[d], o.occ[d]); sum(life[d], o.life[d]); unfinished[d] += o.unfinished[d]; }
+        sum(deaths, o.deaths);
+        sum(spawns, o.spawns);
+        sum(spawn_done, o.spawn_done);
+        sum(spawn_life, o.spawn_life);
+    }
+};
+
+struct Batch {
+    GameMode mode;
+    int matches, bikes;
+    long ticks;
+    std::atomic<int> next{0};
+
+    int classes() const { return mode == MODE_AUTO ? 1 : NDIFF; }
+    const char* const* labels() const { return mode == MODE_AUTO ? auto_label : diff_label; }
+    int class_of(const Slot& s) const { return mode == MODE_AUTO ? 0 : s.diff; }
+};
+
+// one match: every tick, each live head counts toward its cell; spawn and
+// death events close off lives
+void play(Sim::World& w, Slot* slots, const Batch& b, uint32_t seed, Acc& acc) {
+    int spawn_tick[Sim::MAX_PLAYERS], spawn_at[Sim::MAX_PLAYERS];
+    auto events = [&]() {
+        for (const Sim::Event& e : w.events) {
+            int p = e.player, i = e.y * GW + e.x, d = b.class_of(slots[p]);
+            if (e.kind == Sim::EV_SPAWN || e.kind == Sim::EV_RESPAWN) {
+                spawn_tick[p] = w.tick;
+                spawn_at[p] = i;
+                acc.spawns[i]++;
+            } else if (e.kind == Sim::EV_DEATH) {
+                int len = w.tick - spawn_tick[p];
+                acc.life[d][len]++;
+                acc.deaths[i]++;
+                acc.spawn_done[spawn_at[p]]++;
+                acc.spawn_life[spawn_at[p]] += len;
+            }
+        }
+        w.events.clear();
+    };
+    w.track_events = true;
+    Sim::start_round(w, slots, b.bikes, seed);
+    events();
+    for (long t=0; t<b.ticks; t++) {
+        Sim::tick(w);
+        events();
+        for (int k=0; k<w.num_players; k++) {
+            const Player& p = w.players[k];
+            if (p.alive) acc.occ[b.class_of(slots[k])][w.idx(p.x, p.y)]++;
+        }
+    }
+    for (int k=0; k<w.num_players; k++)
+        if (w.players[k].alive) acc.unfinished[b.class_of(slots[k])]++;
+}
+
+void worker(Batch& b, Acc& acc) {
+    std::unique_ptr<Sim::World> w(new Sim::World);
+    Slot slots[Sim::MAX_PLAYERS];
+    // endless: difficulties take turns, so each gets a fair share of every
+    // match. auto: the lobby's default, so only Hard's boosts don't mix in
+    for (int i=0; i<b.bikes; i++) {
+        AIDiff d = b.mode == MODE_AUTO ? AI_MED : (AIDiff)(i % NDIFF);
+        slots[i] = {false, (PColor)(i % PC_COUNT), 0, d, 0};
+    }
+    Sim::create(*w, b.mode, GW, GH, 55, 0);
+    for (int k; (k = b.next++) < b.matches; ) play(*w, slots, b, (uint32_t)k + 1, acc);
+}
+
+// 8-bit greyscale, log scale so the quiet cells still show
+bool write_pgm(const std::string& path, const std::vector<double>& v) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    double mx = *std::max_element(v.begin(), v.end());
+    fprintf(f, "P5\n%d %d\n255\n", GW, GH);
+    for (double x : v) fputc(mx > 0 ? (int)std::lround(255 * std::log1p(x) / std::log1p(mx)) : 0, f);
+    return fclose(f) == 0;
+}
+
+std::vector<double> as_double(const std::vector<uint64_t>& v) { return std::vector<double>(v.begin(), v.end()); }
+
+// distance to the nearest wall cell (the open arena: the border)
+int wall_dist(int i) {
+    int x = i % GW, y = i / GW;
+    return std::min(std::min(x, GW-1-x), std::min(y, GH-1-y));
+}
+}
+
+int Heatmap::run(int argc, char* argv[]) {
+    GameMode mode = MODE_AUTO;
+    if (argc < 3 || (strcmp(argv[2], "auto") != 0 && strcmp(argv[2], "endless") != 0)) {
+        fprintf(stderr, "usage: %s heatmap <auto|endless> [matches] [ticks] [bikes] [dir]\n"
+                        "  endless: curves and wall ratios per difficulty (easy/medium/hard)\n"
+                        "  auto: one class, since AutoTron tunes every bike alike\n", argv[0]);
+        return 2;
+    }
+    if (strcmp(argv[2], "endless") == 0) mode = MODE_ENDLESS;
+    Batch b;
+    b.mode    = mode;
+    b.matches = argc > 3 ? atoi(argv[3]) : 64;
+    b.ticks   = argc > 4 ? atol(argv[4]) : 5000;
+    b.bikes   = argc > 5 ? atoi(argv[5]) : 8;
+    std::string dir = argc > 6 ? argv[6] : "heatmap";
+    if (b.matches < 1 || b.ticks < 1 || b.ticks > 10000000 || b.bikes < 1 || b.bikes > Sim::MAX_PLAYERS) {
+        fprintf(stderr, "tron: bad matches, ticks or bikes\n");
+        return 2;
+    }
+    mkdir(dir.c_str(), 0755);
+
+    int nthreads = std::max(1, std::min((int)std::thread::hardware_concurrency(), b.matches));
+    std::vector<std::unique_ptr<Acc>> accs;
+    std::vector<std::thread> pool;
+    for (int t=0; t<nthreads; t++) accs.emplace_back(new Acc(b.ticks));
+    for (int t=0; t<nthreads; t++) pool.emplace_back(worker, std::ref(b), std::ref(*accs[t]));
+    for (auto& th : pool) th.join();
+    Acc& all = *accs[0];
+    for (int t=1; t<nthreads; t++) all.add(*accs[t]);
+
+    // heatmaps
+    std::vector<double> occ(GW*GH, 0), mean_life(GW*GH, 0);
+    for (int d=0; d<NDIFF; d++)
+        for (int i=0; i<GW*GH; i++) occ[i] += all.occ[d][i];
+    for (int i=0; i<GW*GH; i++)
+        if (all.spawn_done[i]) mean_life[i] = (double)all.spawn_life[i] / all.spawn_done[i];
+    bool ok = write_pgm(dir + "/occupancy.pgm", occ) &&
+              write_pgm(dir + "/deaths.pgm", as_double(all.deaths)) &&
+              write_pgm(dir + "/spawns.pgm", as_double(all.spawns)) &&
+              write_pgm(dir + "/spawn_life.pgm", mean_life);
+
+    // per cell, for plotting elsewhere
+    int nc = b.classes();
+    const char* const* label = b.labels();
+    if (FILE* f = fopen((dir + "/cells.csv").c_str(), "w")) {
+        fprintf(f, "x,y,occupancy");
+        if (nc > 1) for (int d=0; d<nc; d++) fprintf(f, ",%s", label[d]);
+        fprintf(f, ",deaths,spawns,mean_life\n");
+        for (int i=0; i<GW*GH; i++) {
+            fprintf(f, "%d,%d,%.0f", i % GW, i / GW, occ[i]);
+            if (nc > 1) for (int d=0; d<nc; d++) fprintf(f, ",%llu", (unsigned long long)all.occ[d][i]);
+            fprintf(f, ",%llu,%llu,%.1f\n", (unsigned long long)all.deaths[i],
+                    (unsigned long long)all.spawns[i], mean_life[i]);
+        }
+        ok = (fclose(f) == 0) && ok;
+    } else ok = false;
+
+    // survival: share of finished lives that lasted at least t ticks
+    if (FILE* f = fopen((dir + "/survival.csv").c_str(), "w")) {
+        fprintf(f, "ticks");
+        for (int d=0; d<nc; d++) fprintf(f, ",%s", label[d]);
+        fprintf(f, "\n");
+        uint64_t n[NDIFF] = {}, left[NDIFF];
+        for (int d=0; d<nc; d++) {
+            for (uint64_t c : all.life[d]) n[d] += c;
+            left[d] = n[d];
+        }
+        long step = std::max(1L, b.ticks / 500);
+        for (long t=0; t<=b.ticks; t++) {
+            if (t % step == 0) {
+                fprintf(f, "%ld", t);
+                for (int d=0; d<nc; d++) fprintf(f, ",%.4f", n[d] ? (double)left[d] / n[d] : 0.0);
+                fprintf(f, "\n");
+            }
+            for (int d=0; d<nc; d++) left[d] -= all.life[d][t];
+        }
+        ok = (fclose(f) == 0) && ok;
+    } else ok = false;
+    if (!ok) { perror(dir.c_str()); return 1; }
+
+    // what to look at first: wall hugging and spawn fairness
+    printf("%d %s matches x %ld ticks, %d bikes, %dx%d, %d threads -> %s/\n", b.matches,
+           mode_name[mode], b.ticks, b.bikes, GW, GH, nthreads, dir.c_str());
+    int edge_cells = 0;
+    for (int i=0; i<GW*GH; i++) if (wall_dist(i) == 1) edge_cells++;
+    double edge_area = (double)edge_cells / ((GW-2) * (GH-2));
+    printf("\n%-8s %8s %10s %12s %18s\n", "ai", "lives", "mean life", "still alive", "next to wall x");
+    for (int d=0; d<nc; d++) {
+        uint64_t lives = 0, total = 0, edge = 0, head = 0;
+        for (size_t t=0; t<all.life[d].size(); t++) { lives += all.life[d][t]; total += t * all.life[d][t]; }
+        for (int i=0; i<GW*GH; i++) {
+            head += all.occ[d][i];
+            if (wall_dist(i) == 1) edge += all.occ[d][i];
+        }
+        // head-time on cells touching a wall, over those cells' share of the floor
+        printf("%-8s %8llu %10.1f %12llu %17.2fx\n", label[d], (unsigned long long)lives,
+               lives ? (double)total / lives : 0.0, (unsigned long long)all.unfinished[d],
+               head ? (double)edge / head / edge_area : 0.0);
+    }
+    printf("\n%-14s %8s %10s\n", "spawned", "lives", "mean life");
+    const struct { int lo, hi; const char* name; } bands[] = {
+        {1, 7, "< 8 from wall"}, {8, 15, "8-15"}, {16, 1 << 30, "16+"}};
+    for (auto& band : bands) {
+        uint64_t lives = 0, total = 0;
+        for (int i=0; i<GW*GH; i++) {
+            int d = wall_dist(i);
+            if (d < band.lo || d > band.hi) continue;
+            lives += all.spawn_done[i];
+            total += all.spawn_life[i];
+        }
+        printf("%-14s %8llu %10.1f\n", band.name, (unsigned long long)lives, lives ? (double)total / lives : 0.0);
+    }
+    return 0;
+}
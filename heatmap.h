@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Heatmap {
+    // ./tron heatmap <auto|endless> [matches] [ticks] [bikes] [dir]: headless
+    // matches on every core, then per-cell heatmaps (PGM) and survival curves
+    // per difficulty (CSV) written to dir
+    int run(int argc, char* argv[]);
+}
@@ -0,0 +1,139 @@
+#include "history.h"
+#include "config.h"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// history      append-only array of Match records
+// history.idx  per (day, mode, diff) aggregates + how many records are folded in
+//
+// both files are only touched while holding flock(LOCK_EX) on the log, so two
+// ./tron processes interleave whole records instead of losing each other's.
+// the index is derived data: if it is missing, stale or from another build it
+// gets rebuilt / caught up from the log.
+
+namespace {
+constexpr uint32_t IDX_MAGIC   = 0x58495254; // "TRIX"
+constexpr uint32_t IDX_VERSION = 1;
+
+struct IdxHeader {
+    uint32_t magic, version;
+    uint64_t folded; // records of the log already counted in the buckets
+};
+
+struct Bucket {
+    int32_t  day;    // unix time / 86400
+    uint8_t  mode, diff;
+    uint16_t pad;
+    uint32_t rounds, wins;
+    float    total_time, best_time;
+};
+}
+
+static std::vector<Bucket> buckets;
+static uint64_t folded = 0;
+
+static std::string log_path() { return Config::dir() + "/history"; }
+static std::string idx_path() { return Config::dir() + "/history.idx"; }
+
+static void fold(const History::Match& m) {
+    int32_t day = (int32_t)(m.when / 86400);
+    // records arrive in time order, so the bucket is almost always near the back
+    Bucket* b = nullptr;
+    for (int i=(int)buckets.size()-1; i>=0; i--) {
+        Bucket& c = buckets[i];
+        if (c.day == day && c.mode == m.mode && c.diff == m.diff) { b = &c; break; }
+        if (c.day < day - 1) break;
+    }
+    if (!b) {
+        buckets.push_back({day, m.mode, m.diff, 0, 0, 0, 0.0f, 0.0f});
+        b = &buckets.back();
+    }
+    b->rounds++;
+    if (m.human_won) b->wins++;
+    b->total_time += m.duration;
+    if (m.duration > b->best_time) b->best_time = m.duration;
+}
+
+// caller holds the log lock
+static void sync_index(int log_fd) {
+    struct stat st;
+    if (fstat(log_fd, &st) != 0) return;
+    uint64_t total = (uint64_t)st.st_size / sizeof(History::Match);
+
+    int fd = open(idx_path().c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return;
+
+    IdxHeader h{};
+    buckets.clear(); folded = 0;
+    if (read(fd, &h, sizeof(h)) == (ssize_t)sizeof(h) &&
+        h.magic == IDX_MAGIC && h.version == IDX_VERSION && h.folded <= total) {
+        struct stat ist;
+        fstat(fd, &ist);
+        size_t n = ((size_t)ist.st_size - sizeof(h)) / sizeof(Bucket);
+        buckets.resize(n);
+        if (n && read(fd, buckets.data(), n*sizeof(Bucket)) != (ssize_t)(n*sizeof(Bucket)))
+            buckets.clear();
+        else
+            folded = h.folded;
+    }
+
+    if (folded < total) {
+        History::Match chunk[256];
+        off_t off = (off_t)(folded * sizeof(History::Match));
+        while (folded < total) {
+            size_t want = total - folded;
+            if (want > 256) want = 256;
+            ssize_t got = pread(log_fd, chunk, want*sizeof(History::Match), off);
+            if (got <= 0) break;
+            size_t recs = (size_t)got / sizeof(History::Match);
+            for (size_t i=0; i<recs; i++) fold(chunk[i]);
+            folded += recs;
+            off += (off_t)(recs * sizeof(History::Match));
+        }
+        h = {IDX_MAGIC, IDX_VERSION, folded};
+        size_t bytes = buckets.size()*sizeof(Bucket);
+        if (ftruncate(fd, (off_t)(sizeof(h) + bytes)) == 0 &&
+            pwrite(fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && bytes)
+            (void)!pwrite(fd, buckets.data(), bytes, sizeof(h));
+    }
+    close(fd);
+}
+
+void History::append(const Match& m) {
+    int fd = open(log_path().c_str(), O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) return;
+    if (flock(fd, LOCK_EX) == 0) {
+        if (write(fd, &m, sizeof(m)) == (ssize_t)sizeof(m))
+            sync_index(fd);
+        flock(fd, LOCK_UN);
+    }
+    close(fd);
+}
+
+void History::refresh() {
+    int fd = open(log_path().c_str(), O_RDONLY);
+    if (fd < 0) { buckets.clear(); folded = 0; return; }
+    if (flock(fd, LOCK_EX) == 0) {
+        sync_index(fd);
+        flock(fd, LOCK_UN);
+    }
+    close(fd);
+}
+
+History::Stats History::query(int mode, int diff, int64_t since) {
+    Stats s;
+    int32_t since_day = (int32_t)(since / 86400);
+    for (auto& b : buckets) {
+        if (mode >= 0 && b.mode != mode) continue;
+        if (diff >= 0 && b.diff != diff) continue;
+        if (since > 0 && b.day < since_day) continue;
+        s.rounds     += b.rounds;
+        s.wins       += b.wins;
+        s.total_time += b.total_time;
+        if (b.best_time > s.best_time) s.best_time = b.best_time;
+    }
+    return s;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "types.h"
+#include <cstdint>
+
+namespace History {
+    // one finished round, stored as-is in the append-only log
+    struct Match {
+        int64_t  when;         // unix time the round ended
+        uint8_t  mode;         // GameMode
+        uint8_t  nslots;
+        int8_t   winner;       // slot index, -1 = draw / no winner
+        uint8_t  human_won;
+        uint8_t  human_mask;   // bit i set = slot i was human
+        uint8_t  diff;         // hardest CPU in the round, 0xff = no CPU
+        uint8_t  pad[2];
+        uint32_t seed;
+        float    duration;     // seconds
+        uint32_t survival[8];  // ticks each slot stayed alive
+    };
+
+    struct Stats {
+        int    rounds     = 0;
+        int    wins       = 0;
+        double total_time = 0.0;
+        double best_time  = 0.0;
+    };
+
+    void append(const Match& m);
+
+    // bring the in-memory index up to date with the log. cheap when nothing changed.
+    void refresh();
+    // aggregate over the index. mode/diff -1 = any, since 0 = all time.
+    Stats query(int mode, int diff, int64_t since);
+}
@@ -0,0 +1,85 @@
+#include "latency.h"
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+namespace {
+constexpr int SLOTS = 8; // humans only ever sit in the first 8 slots
+
+struct Pending {
+    int64_t wait = 0;       // bound on time unread in the tty
+    int64_t read = -1;      // -1 = nothing pending
+    int64_t moved = -1;
+};
+
+bool on = false;
+int64_t last_poll = -1, prev_poll = -1;
+Pending pend[SLOTS];
+std::vector<int64_t> s_wait, s_move, s_show, s_total;
+long superseded = 0;
+
+int64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void line(FILE* f, const char* name, std::vector<int64_t>& v) {
+    std::sort(v.begin(), v.end());
+    auto pct = [&](int p) { return v[std::min(v.size()-1, v.size() * p / 100)] / 1e6; };
+    fprintf(f, "  %-16s p50 %7.2fms  p90 %7.2fms  p99 %7.2fms  max %7.2fms\n",
+            name, pct(50), pct(90), pct(99), v.back() / 1e6);
+}
+}
+
+void Latency::enable() { on = true; }
+bool Latency::enabled() { return on; }
+
+void Latency::polled() {
+    if (!on) return;
+    prev_poll = last_poll;
+    last_poll = now_ns();
+}
+
+void Latency::key(int player) {
+    if (!on || player < 0 || player >= SLOTS) return;
+    Pending& p = pend[player];
+    if (p.read >= 0 && p.moved < 0) superseded++; // turned again before moving
+    p.read  = last_poll;
+    p.wait  = prev_poll >= 0 ? last_poll - prev_poll : 0;
+    p.moved = -1;
+}
+
+void Latency::moved(int player) {
+    if (!on || player < 0 || player >= SLOTS) return;
+    Pending& p = pend[player];
+    if (p.read >= 0 && p.moved < 0) p.moved = now_ns();
+}
+
+void Latency::shown() {
+    if (!on) return;
+    int64_t t = now_ns();
+    for (Pending& p : pend) {
+        if (p.moved < 0) continue;
+        s_wait.push_back(p.wait);
+        s_move.push_back(p.moved - p.read);
+        s_show.push_back(t - p.moved);
+        s_total.push_back(p.wait + t - p.read);
+        p = Pending{};
+    }
+}
+
+void Latency::drop() {
+    for (Pending& p : pend) p = Pending{};
+}
+
+void Latency::report(FILE* f, int tick_ms) {
+    if (!on || s_total.empty()) return;
+    fprintf(f, "tron: input latency over %zu turns (tick %dms, %ld superseded before moving)\n",
+            s_total.size(), tick_ms, superseded);
+    line(f, "unread (bound)", s_wait);
+    line(f, "read -> move", s_move);
+    line(f, "move -> shown", s_show);
+    line(f, "worst case", s_total);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdio>
+
+// --latency: follow each human turn from the key read to the refresh that
+// shows the bike moving its new way, and print the distribution on exit.
+// keys sit in the tty until the loop polls, so each sample also records how
+// long the previous poll was ago: the most the key can have waited unread.
+namespace Latency {
+    void enable();
+    bool enabled();
+
+    void polled();                 // handle_input looked for a key (got one or not)
+    void key(int player);          // that key just changed a human's direction
+    void moved(int player);        // the tick moved that bike
+    void shown();                  // refresh() put every moved turn on screen
+    void drop();                   // new round: forget turns still in flight
+
+    // percentiles per stage; nothing if no turns were traced
+    void report(FILE* f, int tick_ms);
+}
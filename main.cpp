@@ -1,18 +1,84 @@
 #include "menu.h"
 #include "game.h"
 #include "config.h"
+#include "bench.h"
+#include "heatmap.h"
+#include "arena.h"
+#include "events.h"
+#include "latency.h"
+#include "snapshot.h"
+#include "spectate.h"
 #include <clocale>
+#include <cstdio>
 #include <cstring>
 #include <ncurses.h>
 
+// finish writing the --events file; say so if the ring ever overflowed
+static void report_events() {
+    long dropped = Events::close();
+    if (dropped) fprintf(stderr, "tron: events: %ld dropped (writer fell behind)\n", dropped);
+}
+
 int main(int argc, char* argv[]) {
     setlocale(LC_ALL, "");
+    // ./tron bench / mapgen / heatmap — headless, no terminal needed
+    if (argc > 1 && strcmp(argv[1],"bench")==0) return Bench::run(argc, argv);
+    if (argc > 1 && strcmp(argv[1],"heatmap")==0) return Heatmap::run(argc, argv);
+    if (argc > 1 && strcmp(argv[1],"mapgen")==0) return Arena::mapgen(argc, argv);
+
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i],"--low-power")==0) Game::opts().low_power = true;
+        if (strcmp(argv[i],"--map")==0 && i+1<argc) {
+            Game::opts().map_file = argv[++i];
+            Arena::Map probe;
+            if (!Arena::load(probe, Game::opts().map_file)) {
+                fprintf(stderr, "tron: %s: not a valid map file\n", argv[i]);
+                return 1;
+            }
+        }
+        if (strcmp(argv[i],"--latency")==0) Latency::enable();
+        if (strcmp(argv[i],"--publish")==0 && !Spectate::publishing() && !Spectate::open()) {
+            fprintf(stderr, "tron: can't publish for spectators (another game already is?)\n");
+            return 1;
+        }
+        if (strcmp(argv[i],"--events")==0 && i+1<argc) {
+            if (!Events::open(argv[++i])) {
+                fprintf(stderr, "tron: %s: can't write events\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+
+    // ./tron resume — carry on with the match suspended with Z
+    Snapshot::Meta resume;
+    bool resuming = argc > 1 && strcmp(argv[1],"resume")==0;
+    if (resuming) {
+        Game::opts().resume_file = Snapshot::path();
+        if (!Snapshot::peek(Game::opts().resume_file, resume)) {
+            fprintf(stderr, "tron: no suspended match in %s\n", Game::opts().resume_file.c_str());
+            return 1;
+        }
+        Arena::Map probe;
+        if (!resume.map_file.empty() && !Arena::load(probe, resume.map_file)) {
+            fprintf(stderr, "tron: %s: map of the suspended match is gone\n", resume.map_file.c_str());
+            return 1;
+        }
+    }
+
     initscr(); cbreak(); noecho();
     curs_set(0);
     keypad(stdscr, TRUE);
     Menu::init_colors();
     Config::init();
 
+    // ./tron watch — spectate the game another terminal publishes
+    if (argc > 1 && strcmp(argv[1],"watch")==0) {
+        int r = Game::watch();
+        endwin();
+        if (r < 0) { fprintf(stderr, "tron: terminal too small to watch\n"); return 1; }
+        return 0;
+    }
+
     // ./tron auto  or  ./tron a  — jump straight into autotron
     if (argc > 1 && (strcmp(argv[1],"auto")==0 || strcmp(argv[1],"a")==0)) {
         GameMode mode = MODE_AUTO;
@@ -22,6 +88,21 @@ int main(int argc, char* argv[]) {
             slots[i] = {false, cols[i], 0, AI_HARD, 1}; // team=1 = camera mode
         Game::run(mode, slots);
         endwin();
+        Spectate::close();
+        report_events();
+        if (Game::cpu_percent() >= 0)
+            printf("tron: low-power average CPU %.2f%%\n", Game::cpu_percent());
+        return 0;
+    }
+
+    if (resuming) {
+        Slot slots[8];
+        for (int i=0; i<8 && i<(int)resume.slots.size(); i++) slots[i] = resume.slots[i];
+        Game::run(resume.mode, slots);
+        endwin();
+        Spectate::close();
+        report_events();
+        Latency::report(stderr, Config::get().tick_ms);
         return 0;
     }
 
@@ -31,5 +112,8 @@ int main(int argc, char* argv[]) {
         Game::run(mode, slots);
 
     endwin();
+    Spectate::close();
+    report_events();
+    Latency::report(stderr, Config::get().tick_ms);
     return 0;
 }
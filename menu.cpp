@@ -1,6 +1,9 @@
 #include "menu.h"
 #include "config.h"
+#include "history.h"
+#include "arena.h"
 #include <cstring>
+#include <ctime>
 
 static short nc_color(PColor c) {
     switch(c) {
@@ -113,12 +116,18 @@ static int mode_select() {
     erase();
     draw_title();
     center(7, "-- Select Mode --", CP_DIM);
-    return vmenu(9, {
+    static const GameMode modes[] = {MODE_1V1, MODE_FFA, MODE_2V2, MODE_3V3,
+                                     MODE_4X2, MODE_2X4, MODE_ENDLESS};
+    int i = vmenu(9, {
         {"  1v1  ",              "Classic duel - you vs one opponent"},
         {"  FFA (4 players)  ",  "Free for all - last one standing wins"},
         {"  2v2 Teams  ",        "Team up - teammates can cross each other's trails"},
-        {"  Endless  ",          "Solo survival - 7 AI, they respawn, you don't"},
+        {"  3v3 Teams  ",        "Two teams of three"},
+        {"  4x2 Teams  ",        "Four teams of two - last team standing wins"},
+        {"  2x4 Teams  ",        "Two teams of four"},
+        {"  Endless  ",          "Survival - AI respawn, you don't (2 humans: split screen)"},
     });
+    return i < 0 ? -1 : modes[i];
 }
 
 static void draw_slot_card(int y, int x, int w, int idx, Slot& sl, int cursor, int field) {
@@ -152,9 +161,15 @@ static void draw_slot_card(int y, int x, int w, int idx, Slot& sl, int cursor, i
 
 static bool lobby(GameMode mode, Slot slots[8]) {
     int n = mode_players(mode);
-    if (mode == MODE_2V2) {
-        slots[0].team=0; slots[1].team=0;
-        slots[2].team=1; slots[3].team=1;
+    int teams = mode_teams(mode);
+    for (int i=0; i<n && teams; i++) slots[i].team = mode_team_of(mode, i);
+    // "Team 1: P1+P2  |  Team 2: P3+P4"
+    std::string team_line;
+    for (int t=0; t<teams; t++) {
+        team_line += (t ? "  |  Team " : "Team ") + std::to_string(t+1) + ":";
+        for (int i=0; i<n; i++)
+            if (mode_team_of(mode, i) == t)
+                team_line += (team_line.back()==':' ? " P" : "+P") + std::to_string(i+1);
     }
     int cursor=0, field=0;
     timeout(-1);
@@ -163,7 +178,6 @@ static bool lobby(GameMode mode, Slot slots[8]) {
         erase();
         center(1, "-- Player Setup --", CP_TITLE, true);
         center(2, mode_name[mode], CP_DIM);
-        if (mode==MODE_2V2) center(3, "Team 1               Team 2", CP_DIM);
 
         // cards: fit as many as we can across the terminal
         int card_w = 20, gap = 1;
@@ -178,8 +192,8 @@ static bool lobby(GameMode mode, Slot slots[8]) {
         int info_y = 14;
         center(info_y,   "[<>] Switch player  [v^] Switch field  [Enter] Cycle value", CP_DIM);
         center(info_y+1, "[Space] Start game  [Q] Back", CP_DIM);
-        if (mode==MODE_2V2)
-            center(info_y+2, "Team 1: P1+P2  |  Team 2: P3+P4", CP_HUD);
+        if (teams)
+            center(info_y+2, team_line.c_str(), CP_HUD);
         refresh();
 
         int ch = getch();
@@ -195,14 +209,9 @@ static bool lobby(GameMode mode, Slot slots[8]) {
                         dup_keys=true;
                 }
             }
-            // endless requires exactly 1 human
-            if (mode==MODE_ENDLESS && humans!=1) {
-                center(info_y+3, "Endless mode: exactly 1 human player!", CP_HUD, true);
-                refresh(); napms(1000); continue;
-            }
             const char* err = nullptr;
             if (!has_human && mode!=MODE_AUTO) err = "Need at least 1 human player!";
-            if (humans > 2 && mode!=MODE_ENDLESS) err = "Max 2 human players!";
+            if (humans > 2) err = "Max 2 human players!";
             if (dup_color) err = "Each player needs a unique color!";
             if (dup_keys)  err = "Human players need different controls!";
             if (err) { center(info_y+3, err, CP_HUD, true); refresh(); napms(1000); continue; }
@@ -238,9 +247,9 @@ void Menu::show_scores() {
         erase();
         center(1, "-- High Scores --", CP_TITLE, true);
 
-        const char* tabs[] = {"[1] Overview", "[2] Streaks", "[3] Time"};
-        for (int i=0; i<3; i++) {
-            int x = COLS/2 - 25 + i*18;
+        const char* tabs[] = {"[1] Overview", "[2] Streaks", "[3] Time", "[4] History"};
+        for (int i=0; i<4; i++) {
+            int x = COLS/2 - 34 + i*17;
             attron(COLOR_PAIR(i==tab ? CP_SEL : CP_DIM) | (i==tab ? A_BOLD : 0));
             mvaddstr(3, x, tabs[i]);
             attroff(COLOR_PAIR(i==tab ? CP_SEL : CP_DIM) | (i==tab ? A_BOLD : 0));
@@ -266,9 +275,37 @@ void Menu::show_scores() {
                 snprintf(buf,64,"Best Round Time:  %.1fs", s.best_time);    mvaddstr(y++,COLS/2-15,buf);
                 snprintf(buf,64,"Best Endless:     %.1fs", s.best_endless); mvaddstr(y++,COLS/2-15,buf);
                 break;
+            case 3: {
+                // aggregates come from the history index, not a scan of the log
+                History::refresh();
+                int64_t week = (int64_t)time(nullptr) - 7*86400;
+                auto row = [&](const char* label, int m, int d) {
+                    History::Stats all = History::query(m, d, 0);
+                    History::Stats wk  = History::query(m, d, week);
+                    char line[96];
+                    snprintf(line, sizeof(line), "%-10s %6d %4.0f%% %6.1fs   %6d %4.0f%% %6.1fs", label,
+                             all.rounds, all.rounds ? 100.0*all.wins/all.rounds : 0.0,
+                             all.rounds ? all.total_time/all.rounds : 0.0,
+                             wk.rounds, wk.rounds ? 100.0*wk.wins/wk.rounds : 0.0,
+                             wk.rounds ? wk.total_time/wk.rounds : 0.0);
+                    mvaddstr(y++, COLS/2-27, line);
+                };
+                attron(COLOR_PAIR(CP_DIM));
+                mvaddstr(y++, COLS/2-27, "           -------- All --------   ------ Last 7d ------");
+                mvaddstr(y++, COLS/2-27, "           Rounds  Win%    Avg     Rounds  Win%    Avg");
+                attroff(COLOR_PAIR(CP_DIM));
+                attron(COLOR_PAIR(CP_HUD));
+                for (int m=0; m<MODE_COUNT; m++)
+                    if (m != MODE_AUTO) row(mode_name[m], m, -1);
+                y++;
+                for (int d=AI_EASY; d<=AI_HARD; d++) row(diff_name[d], -1, d);
+                y++;
+                row("Total", -1, -1);
+                break;
+            }
         }
         attroff(COLOR_PAIR(CP_HUD));
-        center(LINES-3, "[1/2/3] Switch tab  [Q] Back", CP_DIM);
+        center(LINES-3, "[1-4] Switch tab  [Q] Back", CP_DIM);
         refresh();
 
         int ch = getch();
@@ -276,28 +313,73 @@ void Menu::show_scores() {
         if (ch=='1') tab=0;
         if (ch=='2') tab=1;
         if (ch=='3') tab=2;
-        if (ch==KEY_LEFT) tab=(tab+2)%3;
-        if (ch==KEY_RIGHT) tab=(tab+1)%3;
+        if (ch=='4') tab=3;
+        if (ch==KEY_LEFT) tab=(tab+3)%4;
+        if (ch==KEY_RIGHT) tab=(tab+1)%4;
     }
 }
 
 void Menu::show_settings() {
     auto& cfg = Config::get();
+    // 0 = unlimited; anything else turns every mode into the bounded-trail variant
+    static const int trail_opts[] = {0, 40, 80, 160, 320};
+    constexpr int n_trail = sizeof(trail_opts)/sizeof(trail_opts[0]);
+    // 0 = the mode's own count; bigger crowds lean on the sim's level-of-detail ai
+    static const int crowd_opts[] = {0, 16, 32, 64};
+    constexpr int n_crowd = sizeof(crowd_opts)/sizeof(crowd_opts[0]);
+    auto cycle = [](const int* opts, int n, int& val, int step) {
+        int cur = 0;
+        for (int i=0; i<n; i++) if (opts[i] == val) cur = i;
+        val = opts[(cur + step + n) % n];
+    };
+    int sel = 0;
     timeout(-1);
     while (true) {
         erase();
         center(1, "-- Settings --", CP_TITLE, true);
         char buf[64];
         snprintf(buf, 64, "Game Speed (tick ms): %d", cfg.tick_ms);
-        attron(COLOR_PAIR(CP_SEL));
+        attron(COLOR_PAIR(sel==0 ? CP_SEL : CP_HUD));
         mvaddstr(5, COLS/2-18, buf);
-        attroff(COLOR_PAIR(CP_SEL));
-        center(8, "[<>] Adjust  [Q] Save & Back", CP_DIM);
+        attroff(COLOR_PAIR(sel==0 ? CP_SEL : CP_HUD));
+        if (cfg.trail_len > 0) snprintf(buf, 64, "Trail Length:         %d", cfg.trail_len);
+        else                   snprintf(buf, 64, "Trail Length:         Unlimited");
+        attron(COLOR_PAIR(sel==1 ? CP_SEL : CP_HUD));
+        mvaddstr(6, COLS/2-18, buf);
+        attroff(COLOR_PAIR(sel==1 ? CP_SEL : CP_HUD));
+        snprintf(buf, 64, "Arena:                %s", Arena::kind_name[cfg.arena]);
+        attron(COLOR_PAIR(sel==2 ? CP_SEL : CP_HUD));
+        mvaddstr(7, COLS/2-18, buf);
+        attroff(COLOR_PAIR(sel==2 ? CP_SEL : CP_HUD));
+        if (cfg.crowd > 0) snprintf(buf, 64, "Endless/Auto Bikes:   %d", cfg.crowd);
+        else               snprintf(buf, 64, "Endless/Auto Bikes:   Default");
+        attron(COLOR_PAIR(sel==3 ? CP_SEL : CP_HUD));
+        mvaddstr(8, COLS/2-18, buf);
+        attroff(COLOR_PAIR(sel==3 ? CP_SEL : CP_HUD));
+        snprintf(buf, 64, "Endless/Auto Speeds:  %s", cfg.speeds ? "Mixed" : "Same");
+        attron(COLOR_PAIR(sel==4 ? CP_SEL : CP_HUD));
+        mvaddstr(9, COLS/2-18, buf);
+        attroff(COLOR_PAIR(sel==4 ? CP_SEL : CP_HUD));
+        center(11, "[v^] Select  [<>] Adjust  [Q] Save & Back", CP_DIM);
         refresh();
         int ch = getch();
         if (ch=='q'||ch=='Q'||ch==27) { Config::save(); return; }
-        if (ch==KEY_RIGHT && cfg.tick_ms < 150) cfg.tick_ms += 5;
-        if (ch==KEY_LEFT  && cfg.tick_ms > 20)  cfg.tick_ms -= 5;
+        if (ch==KEY_UP)   sel = (sel+4) % 5;
+        if (ch==KEY_DOWN) sel = (sel+1) % 5;
+        if (ch!=KEY_RIGHT && ch!=KEY_LEFT) continue;
+        int step = ch==KEY_RIGHT ? 1 : -1;
+        if (sel == 0) {
+            if (ch==KEY_RIGHT && cfg.tick_ms < 150) cfg.tick_ms += 5;
+            if (ch==KEY_LEFT  && cfg.tick_ms > 20)  cfg.tick_ms -= 5;
+        } else if (sel == 1) {
+            cycle(trail_opts, n_trail, cfg.trail_len, step);
+        } else if (sel == 2) {
+            cfg.arena = (cfg.arena + step + Arena::KIND_COUNT) % Arena::KIND_COUNT;
+        } else if (sel == 3) {
+            cycle(crowd_opts, n_crowd, cfg.crowd, step);
+        } else {
+            cfg.speeds = !cfg.speeds;
+        }
     }
 }
 
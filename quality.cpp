@@ -0,0 +1,246 @@
+#include "quality.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+namespace {
+constexpr double WINDOW_S  = 1.0;  // how often the level is reconsidered
+constexpr double PING_S    = 0.2;  // least time between pings
+constexpr double DEAF_S    = 5;    // first ping unanswered this long: terminal can't
+constexpr double LAG_S     = 0.25; // queue delay that counts as falling behind
+constexpr double BLOCK_S   = 0.005; // a refresh() stuck in write() this long is late
+constexpr int    CALM_UP   = 3;    // calm windows before stepping up
+constexpr int    STARVED   = 4;    // windows a budget can't keep the view current before stepping down
+constexpr int    PROBE_UP  = 10;   // ...or, if the estimate says it won't fit, a probe
+constexpr int    PROBE_MAX = 160;
+constexpr double HEADROOM  = 0.7;  // share of the drain rate a step up may plan on
+constexpr double SPEND     = 0.8;  // share of it a budgeted frame may write
+constexpr int    MIN_CELLS = 32;   // a budgeted frame always paints this many
+// bytes a second going up from a level costs, over staying on it
+constexpr double UP_COST[Quality::LEVELS] = {1, 1.2, 2, 1.3, 1.3};
+constexpr int    EVERY[Quality::LEVELS]   = {1, 1, 1, 2, 4};
+const char* const NAMES[Quality::LEVELS] = {
+    "", "slow link: budget", "slow link: ascii", "slow link: 1/2 fps", "slow link: 1/4 fps"
+};
+// save the cursor, query it at home (so the answer is always ESC[1;1R), restore
+const char PING[] = "\0337\033[H\033[6n\0338";
+
+Quality::Level lvl = Quality::FULL;
+double rate = 0;        // bytes/s the terminal drains, 0 = not measured yet
+double per_cell = 8;    // bytes written per painted cell
+double interval = 0.05; // s between frames drawn
+double demand = 0;      // cells a frame wanted painted
+long   frame_no = 0;
+int    left = INT_MAX;  // cells this frame may still paint
+int    f_cells = 0, f_deferred = 0;
+int    calm = 0, starved = 0, probe = PROBE_UP, since_up = -1;
+int    io_fd = -2;
+long   out_bytes = 0;   // written by frames so far
+
+// pings: one in flight at a time
+double ping_t = -1;     // when the one in flight went out, -1 = none
+long   ping_bytes = 0;  // out_bytes it went out behind
+double pong_t = -1;     // last answer
+long   pong_bytes = 0;
+double min_rtt = 1e9;   // the link's own latency, as best seen
+double delay = 0;       // how far behind the terminal was, last answer
+bool   heard = false, deaf = false;
+
+// the window being measured. late: frames that found the tty's queue not
+// empty; blocked: time spent stuck in refresh() because it was full
+double w_t0 = -1, w_last = -1, w_blocked = 0;
+long   w_bytes = 0;
+int    w_frames = 0, w_late = 0, w_deferred = 0;
+
+double now_s() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// bytes this thread has passed to write() so far, -1 = can't tell. the
+// process total would count the --events writer too. the fd stays with
+// the thread that opened it, the one that calls flush()
+long written() {
+    if (io_fd == -2) io_fd = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+    if (io_fd < 0) return -1;
+    char buf[512];
+    ssize_t n = pread(io_fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return -1;
+    buf[n] = 0;
+    const char* p = strstr(buf, "wchar:");
+    return p ? atol(p + 6) : -1;
+}
+
+// bytes handed to the tty that nobody has read yet (a pty passes them on
+// at once, so over ssh only the pings see the backlog)
+long backlog() {
+    int n = 0;
+    if (ioctl(STDOUT_FILENO, TIOCOUTQ, &n) != 0) return 0;
+    return n;
+}
+
+// how far behind the terminal is now: the last answer, or the ping still
+// out if it has waited longer than that
+double lag(double t) {
+    if (ping_t >= 0 && heard) return std::max(delay, t - ping_t - min_rtt);
+    return delay;
+}
+
+void ping(double t) {
+    if (write(STDOUT_FILENO, PING, sizeof(PING) - 1) == (ssize_t)sizeof(PING) - 1) {
+        ping_t = t;
+        ping_bytes = out_bytes;
+    }
+}
+
+void step(double t) {
+    double dt = std::max(t - w_t0, 1e-3), d = lag(t);
+    bool stuck = w_late*2 > w_frames || w_blocked > dt/4;
+    // writes held up most of the window went out at the terminal's pace
+    if (!heard && (w_blocked > dt/2 || (w_frames && w_late == w_frames)))
+        rate = rate > 0 ? 0.7*rate + 0.3*w_bytes/dt : w_bytes/dt;
+    // the budget held frames back and nothing queued (as far as the pings, or
+    // without them the writes, can tell): there's room for more
+    else if (w_deferred && d < LAG_S/4 && !stuck && rate > 0)
+        rate = std::max(rate * (heard ? 1.5 : 1.25), w_bytes/dt);
+
+    if (since_up >= 0) since_up++;
+    starved = w_deferred*2 > w_frames ? starved + 1 : 0;
+    bool behind = d > LAG_S || stuck || starved >= STARVED;
+    if (behind) {
+        calm = starved = 0;
+        if (since_up >= 0 && since_up <= 2) probe = std::min(probe * 2, PROBE_MAX); // a probe that failed
+        since_up = -1;
+        if (lvl < Quality::QUARTER) lvl = (Quality::Level)(lvl + 1);
+    } else if (lvl > Quality::FULL && d < LAG_S/2 && !w_late && !w_blocked && w_deferred*4 < w_frames) {
+        calm++;
+        bool fits = rate <= 0 || demand * per_cell / interval * UP_COST[lvl] < HEADROOM * rate;
+        if ((calm >= CALM_UP && fits) || calm >= probe) {
+            lvl = (Quality::Level)(lvl - 1);
+            calm = 0;
+            since_up = 0;
+        }
+    } else {
+        calm = 0;
+    }
+    if (since_up > 2) { probe = PROBE_UP; since_up = -1; } // the step up held
+
+    w_t0 = t;
+    w_blocked = 0;
+    w_bytes = 0;
+    w_frames = w_late = w_deferred = 0;
+}
+}
+
+void Quality::reset() {
+    define_key("\033[1;1R", KEY_PONG);
+    lvl = FULL;
+    rate = 0; per_cell = 8; interval = 0.05; demand = 0;
+    frame_no = 0;
+    left = INT_MAX;
+    f_cells = f_deferred = 0;
+    calm = starved = 0; probe = PROBE_UP; since_up = -1;
+    out_bytes = 0;
+    ping_t = pong_t = -1;
+    ping_bytes = pong_bytes = 0;
+    min_rtt = 1e9; delay = 0;
+    heard = deaf = false;
+    w_t0 = w_last = -1;
+    w_blocked = 0;
+    w_bytes = 0;
+    w_frames = w_late = w_deferred = 0;
+    ping(now_s()); // before anything is drawn: the link's own round trip
+}
+
+void Quality::pause() {
+    if (ping_t >= 0 && !deaf) {
+        // its answer would otherwise turn up late, in the menu or the shell.
+        // keys pressed meanwhile go back for the caller, in order
+        int keys[6], nkeys = 0;
+        timeout(50);
+        for (int k=0; k<6 && ping_t >= 0; k++) {
+            int ch = getch();
+            if (ch == KEY_PONG) pong();
+            else if (ch != ERR) keys[nkeys++] = ch;
+        }
+        timeout(0);
+        while (nkeys) ungetch(keys[--nkeys]);
+        ping_t = -1;
+    }
+    w_t0 = w_last = -1; // the pause is no frame interval
+    w_blocked = 0;
+    w_bytes = 0;
+    w_frames = w_late = w_deferred = 0;
+}
+
+Quality::Level Quality::level() { return lvl; }
+bool Quality::ascii() { return lvl >= ASCII; }
+bool Quality::skip() { return frame_no++ % EVERY[lvl] != 0; }
+int  Quality::cells() { return left; }
+const char* Quality::name() { return NAMES[lvl]; }
+
+void Quality::painted(int cells, int deferred) {
+    f_cells += cells;
+    f_deferred += deferred;
+    if (left != INT_MAX) left = std::max(0, left - cells);
+}
+
+void Quality::pong() {
+    if (ping_t < 0) return;
+    double t = now_s(), rtt = t - ping_t;
+    min_rtt = std::min(min_rtt, rtt);
+    delay = rtt - min_rtt;
+    // behind all the while since the last answer: everything between the
+    // two pings went out at the terminal's pace
+    if (heard && delay > LAG_S/2 && t > pong_t) {
+        double r = (ping_bytes - pong_bytes) / (t - pong_t);
+        rate = rate > 0 ? 0.7*rate + 0.3*r : r;
+    }
+    heard = true;
+    pong_t = t;
+    pong_bytes = ping_bytes;
+    ping_t = -1;
+}
+
+void Quality::flush() {
+    double t = now_s();
+    if (w_t0 < 0) w_t0 = t;
+    else if (t - w_t0 >= WINDOW_S) step(t);
+
+    long q = backlog();
+    long b0 = written();
+    refresh();
+    long b1 = written();
+    double took = now_s() - t;
+    long wrote = b0 >= 0 && b1 >= 0 ? b1 - b0 : (long)(f_cells * per_cell);
+    out_bytes += wrote;
+    // a handful of cells says more about the hud than about cells
+    if (b0 >= 0 && f_cells >= 16) per_cell = 0.9*per_cell + 0.1*std::max(1.0, (double)wrote / f_cells);
+    demand = 0.8*demand + 0.2*(f_cells + f_deferred);
+    if (w_last >= 0) interval = 0.9*interval + 0.1*std::clamp(t - w_last, 1e-3, 1.0);
+    w_last = t;
+
+    w_frames++;
+    w_bytes += wrote;
+    if (q > 0) w_late++;
+    if (took > BLOCK_S) w_blocked += took;
+    if (f_deferred) w_deferred++;
+    f_cells = f_deferred = 0;
+
+    if (ping_t < 0 && !deaf && t - pong_t >= PING_S) {
+        ping(now_s());
+    } else if (ping_t >= 0 && !heard && t - ping_t > DEAF_S) {
+        deaf = true; // never answered: no pings, only the local signs
+        ping_t = -1;
+    }
+
+    left = INT_MAX;
+    if (lvl >= BUDGET && rate > 0) // and drain what's queued over the next second
+        left = std::max(MIN_CELLS, (int)(rate * interval * (SPEND - lag(t)) / per_cell));
+}
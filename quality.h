@@ -0,0 +1,32 @@
+#pragma once
+#include <ncurses.h>
+
+// camera view output that adapts to the link. every frame notes what it
+// wrote and whether the terminal had kept up; a few times a second a ping
+// (a cursor position query, answered once the terminal has worked through
+// everything sent before it) measures how far behind the screen is. once a
+// second the view steps down a level while the terminal lags, and back up
+// when there's room again:
+//   FULL     every changed cell, every frame
+//   BUDGET   a byte budget per frame from the measured drain rate. heads
+//            always, then changed cells, then scroll fills and repaints; the
+//            rest waits for a later frame. no minimap, dead trails don't flash
+//   ASCII    the same, with | - + @ # for the multibyte box glyphs
+//   HALF     the same, drawing every other frame
+//   QUARTER  every fourth frame
+namespace Quality {
+    enum Level { FULL, BUDGET, ASCII, HALF, QUARTER, LEVELS };
+    constexpr int KEY_PONG = KEY_F(63); // the ping's answer, via define_key
+
+    void reset();                // new game: full quality, nothing measured
+    void pause();                // drawing stops a while (countdown, result, quit):
+                                 // a ping in flight is waited out briefly, then dropped
+    Level level();
+    bool ascii();
+    bool skip();                 // once per frame the loop could draw: true = don't
+    int  cells();                // cells this frame may still paint, INT_MAX = no limit
+    void painted(int cells, int deferred); // render_viewport: what it drew and left
+    void flush();                // refresh() the screen, measured; may change level
+    void pong();                 // getch returned KEY_PONG
+    const char* name();          // for the hud: "" at FULL
+}
@@ -0,0 +1,1179 @@
+#include "sim.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Sim;
+
+// compile-time rules of a mode. the kernel is instantiated once per mode so
+// the checks below fold away; Dynamic keeps them as runtime tests (bench baseline).
+template<GameMode M> struct Rules {
+    static constexpr bool teams(const World&)   { return mode_teams(M) > 0; }
+    static constexpr bool respawn(const World&) { return M == MODE_ENDLESS || M == MODE_AUTO; }
+    static constexpr bool endless(const World&) { return M == MODE_ENDLESS; }
+};
+struct Dynamic {
+    static bool teams(const World& w)   { return w.num_teams > 0; }
+    static bool respawn(const World& w) { return w.mode == MODE_ENDLESS || w.mode == MODE_AUTO; }
+    static bool endless(const World& w) { return w.mode == MODE_ENDLESS; }
+};
+
+static uint8_t corner_glyph(Dir from, Dir to) {
+    if (from==to || from==D_NONE) return (to==D_UP||to==D_DOWN)?TG_V:TG_H;
+    if ((from==D_UP   &&to==D_RIGHT)||(from==D_LEFT &&to==D_DOWN))  return TG_UL;
+    if ((from==D_UP   &&to==D_LEFT) ||(from==D_RIGHT&&to==D_DOWN))  return TG_UR;
+    if ((from==D_DOWN &&to==D_RIGHT)||(from==D_LEFT &&to==D_UP))    return TG_DL;
+    if ((from==D_DOWN &&to==D_LEFT) ||(from==D_RIGHT&&to==D_UP))    return TG_DR;
+    return (to==D_UP||to==D_DOWN)?TG_V:TG_H;
+}
+
+template<class R>
+static inline bool blocked_for(const World& w, int x, int y, int team) {
+    if (x<=0||x>=w.GW-1||y<=0||y>=w.GH-1) return true;
+    Cell c = w.grid[w.idx(x,y)];
+    if (R::teams(w)) return !w.pass[team<<8 | c];
+    return c != C_EMPTY;
+}
+
+int Sim::cell_color(const World& w, Cell c) {
+    return w.players[(int)c - (int)C_P1].slot->color;
+}
+
+static inline void blk_adjust(World& w, int i, Cell c, int delta) {
+    if (!w.blk_w || c < C_P1) return;
+    int b = (i / w.GW / w.blk_bh) * w.blk_w + (i % w.GW) / w.blk_bw;
+    w.blk_count[b*PC_COUNT + cell_color(w, c)] += delta;
+    w.blk_fill[b] += delta;
+}
+
+void Sim::paint(World& w, int i, Cell c, uint8_t glyph) {
+    blk_adjust(w, i, w.grid[i], -1);
+    w.grid[i] = c;
+    w.trail_glyph[i] = glyph;
+    blk_adjust(w, i, c, +1);
+}
+
+// ---- empty-space regions ----
+
+// the 8 cells around one, clockwise from north; even entries are the 4-neighbours
+static const int ring_dx[8] = {0, 1, 1, 1, 0,-1,-1,-1};
+static const int ring_dy[8] = {-1,-1, 0, 1, 1, 1, 0,-1};
+
+static inline int parity(const World& w, int i) { return (i % w.GW + i / w.GW) & 1; }
+
+static void region_label_all(World& w) {
+    int n = w.GW*w.GH, step[4] = {-1, 1, -w.GW, w.GW};
+    w.region.assign(n, -1);
+    w.region_size.clear();
+    w.region_odd.clear();
+    auto& q = w.flood_q[0];
+    for (int s=0; s<n; s++) {
+        if (w.grid[s] != C_EMPTY || w.region[s] >= 0) continue;
+        int label = (int)w.region_size.size();
+        q.clear(); q.push_back(s);
+        w.region[s] = label;
+        for (size_t k=0; k<q.size(); k++)
+            for (int d : step) {
+                int c = q[k] + d; // empty cells are never on the border
+                if (w.grid[c] == C_EMPTY && w.region[c] < 0) { w.region[c] = label; q.push_back(c); }
+            }
+        int odd = 0;
+        for (int c : q) odd += parity(w, c);
+        w.region_size.push_back((int)q.size());
+        w.region_odd.push_back(odd);
+    }
+}
+
+// one flood per side of a cut, run in lockstep; floods that meet merge.
+// stops once at most one side is still growing (so the big side is never
+// walked in full), or after budget cells. root_of[] gives each flood's side,
+// growing[] which sides were cut short. returns the number of sides.
+static int flood_sides(World& w, const int* seeds, int ns, long budget, int* root_of, bool* growing) {
+    uint32_t ep = ++w.region_epoch; // marks are ep*4 + flood
+    int step[4] = {-1, 1, -w.GW, w.GW};
+    int parent[4];
+    size_t head[4];
+    for (int g=0; g<ns; g++) {
+        parent[g] = g; head[g] = 0;
+        w.flood_q[g].clear();
+        w.flood_q[g].push_back(seeds[g]);
+        w.region_mark[seeds[g]] = ep*4 + g;
+    }
+    auto root = [&](int g) { while (parent[g] != g) g = parent[g]; return g; };
+
+    int roots;
+    for (;;) {
+        int open = 0;
+        roots = 0;
+        for (int g=0; g<ns; g++) growing[g] = false;
+        for (int g=0; g<ns; g++) {
+            if (root(g) == g) roots++;
+            if (head[g] < w.flood_q[g].size()) growing[root(g)] = true;
+        }
+        for (int g=0; g<ns; g++) open += growing[g];
+        if (roots == 1 || open <= 1 || budget <= 0) break;
+        for (int g=0; g<ns; g++) {
+            if (head[g] >= w.flood_q[g].size()) continue;
+            int c = w.flood_q[g][head[g]++];
+            budget--;
+            for (int d : step) {
+                int nc = c + d;
+                if (w.grid[nc] != C_EMPTY) continue;
+                uint32_t m = w.region_mark[nc];
+                if (m / 4 != ep) { w.region_mark[nc] = ep*4 + g; w.flood_q[g].push_back(nc); continue; }
+                int a = root(g), b = root(m % 4);
+                if (a != b) parent[std::max(a,b)] = std::min(a,b);
+            }
+        }
+    }
+    for (int g=0; g<ns; g++) root_of[g] = root(g);
+    return roots;
+}
+
+// the side still growing keeps the old label, the walked-out ones get fresh
+static void region_split(World& w, int label, const int* seeds, int ns) {
+    int root_of[4];
+    bool growing[4];
+    if (flood_sides(w, seeds, ns, LONG_MAX, root_of, growing) == 1) return;
+
+    int keep = root_of[0], fresh[4] = {-1,-1,-1,-1};
+    for (int g=0; g<ns; g++) if (growing[g]) keep = g;
+    for (int g=0; g<ns; g++) {
+        int r = root_of[g];
+        if (r == keep) continue;
+        if (fresh[r] < 0) {
+            fresh[r] = (int)w.region_size.size();
+            w.region_size.push_back(0);
+            w.region_odd.push_back(0);
+        }
+        int odd = 0;
+        for (int c : w.flood_q[g]) { w.region[c] = fresh[r]; odd += parity(w, c); }
+        w.region_size[fresh[r]] += (int)w.flood_q[g].size();
+        w.region_size[label]    -= (int)w.flood_q[g].size();
+        w.region_odd[fresh[r]]  += odd;
+        w.region_odd[label]     -= odd;
+    }
+    w.regions_changed = true;
+}
+
+// seeds for the sides cell i would separate: its empty ring cells form arcs,
+// and 4-neighbours on one arc stay joined through it. returns the arc count.
+static int ring_arcs(const World& w, int i, int* seeds) {
+    bool empty[8];
+    int k0 = -1;
+    for (int k=0; k<8; k++) {
+        empty[k] = w.grid[i + ring_dy[k]*w.GW + ring_dx[k]] == C_EMPTY;
+        if (!empty[k]) k0 = k;
+    }
+    if (k0 < 0) { seeds[0] = i - w.GW; return 1; }
+    int ns = 0, seed = -1;
+    for (int j=1; j<=8; j++) { // from just past a full cell, so no arc wraps
+        int k = (k0 + j) & 7;
+        if (!empty[k]) { if (seed >= 0) seeds[ns++] = seed; seed = -1; }
+        else if (!(k & 1) && seed < 0) seed = i + ring_dy[k]*w.GW + ring_dx[k];
+    }
+    return ns;
+}
+
+// cell i just went from empty to trail; only two or more arcs can mean a cut
+static void region_fill(World& w, int i) {
+    int label = w.region[i];
+    w.region[i] = -1;
+    if (label < 0) return;
+    w.region_size[label]--;
+    w.region_odd[label] -= parity(w, i);
+    int seeds[4], ns = ring_arcs(w, i, seeds);
+    if (ns >= 2) region_split(w, label, seeds, ns);
+}
+
+// who can still get where. owners are live bikes, or in team modes teams with
+// a live bike; a team may cross its own trails, so every cell of them counts
+// as a way in. sealed once no region has two owners.
+static void update_sealed(World& w) {
+    w.regions_changed = false;
+    bool teams = w.num_teams > 0;
+    int step[4] = {-1, 1, -w.GW, w.GW};
+    int owner_reach[MAX_PLAYERS] = {};
+    bool team_live[8] = {}, shared = false;
+    w.region_owner.assign(w.region_size.size(), -1);
+    auto touch = [&](int o, int x, int y) {
+        int i = w.idx(x, y);
+        for (int d : step) {
+            int l = w.region[i+d];
+            if (l < 0) continue;
+            int& ow = w.region_owner[l];
+            if (ow == -1) { ow = o; owner_reach[o] += w.region_size[l]; }
+            else if (ow != o) { ow = -2; shared = true; }
+        }
+    };
+    for (int i=0; i<w.num_players; i++)
+        if (teams && w.players[i].alive) team_live[w.players[i].team] = true;
+    for (int i=0; i<w.num_players; i++) {
+        const Player& p = w.players[i];
+        if (!teams) {
+            if (p.alive) touch(i, p.x, p.y);
+        } else if (team_live[p.team]) {
+            p.trail.each([&](int x, int y) { touch(p.team, x, y); });
+        }
+    }
+    for (int i=0; i<w.num_players; i++) {
+        const Player& p = w.players[i];
+        bool live = teams ? team_live[p.team] : p.alive;
+        w.reach[i] = live ? owner_reach[teams ? p.team : i] : 0;
+    }
+    if (!shared && !w.sealed) { w.sealed = true; w.sealed_tick = w.tick; }
+
+    // a bike with every side of its head to itself; space only shrinks, so
+    // it stays that way
+    if (teams) return;
+    for (int i=0; i<w.num_players; i++) {
+        Player& p = w.players[i];
+        if (!p.alive || p.alone) continue;
+        bool alone = true;
+        for (int d : step) {
+            int l = w.region[w.idx(p.x, p.y) + d];
+            if (l >= 0 && w.region_owner[l] != i) alone = false;
+        }
+        if (!alone) continue;
+        p.alone = true;
+        p.alone_tick = w.tick;
+        p.alone_room = w.reach[i];
+    }
+}
+
+// longest path through n cells entered on colour q of a checkerboard: steps
+// alternate colours, so at most twice the scarcer colour (+1 if it's the other)
+static inline int path_bound(int nq, int n) {
+    int no = n - nq;
+    return nq > no ? 2*no + 1 : 2*nq;
+}
+
+// upper bound on the cells a bike can still fill after stepping into empty
+// cell c. if c is a cut the sides are walked in lockstep up to endgame_budget
+// cells; sides walked out are exact, whatever is left goes to the rest.
+static int fill_bound(World& w, int c) {
+    int label = w.region[c], q = parity(w, c) ^ 1; // colour of the step after c
+    int tot  = w.region_size[label] - 1;
+    int totq = q ? w.region_odd[label] : tot - w.region_odd[label];
+    int seeds[4], ns = ring_arcs(w, c, seeds);
+    if (ns < 2) return 1 + (ns ? path_bound(totq, tot) : 0);
+
+    int root_of[4];
+    bool growing[4];
+    Cell saved = w.grid[c];
+    w.grid[c] = C_WALL;
+    int sides = flood_sides(w, seeds, ns, w.endgame_budget, root_of, growing);
+    w.grid[c] = saved;
+    if (sides == 1) return 1 + path_bound(totq, tot);
+
+    int n[4] = {}, nq[4] = {}, rest = tot, restq = totq, best = 0;
+    bool open = false;
+    for (int g=0; g<ns; g++) {
+        int r = root_of[g];
+        if (growing[r]) { open = true; continue; }
+        for (int cell : w.flood_q[g]) { n[r]++; nq[r] += parity(w, cell) == q; }
+    }
+    for (int r=0; r<ns; r++) {
+        rest -= n[r]; restq -= nq[r];
+        if (n[r]) best = std::max(best, path_bound(nq[r], n[r]));
+    }
+    if (open) best = std::max(best, path_bound(restq, rest));
+    return 1 + best;
+}
+
+// sealed-in bikes: take the step that leaves the most fillable room, and
+// among equals the one that hugs walls and trails the most (straight on a tie)
+template<class R>
+static void endgame_think(World& w, Player& p) {
+    Dir best = p.dir;
+    int best_cap = -1, best_hug = -1;
+    for (int d=0; d<4; d++) {
+        Dir dd = (Dir)d;
+        if (dd == dir_opposite(p.dir)) continue;
+        int nx = p.x+dir_dx(dd), ny = p.y+dir_dy(dd);
+        if (blocked_for<R>(w, nx, ny, p.team)) continue;
+        int cap = fill_bound(w, w.idx(nx, ny)), hug = 0;
+        for (int e=0; e<4; e++)
+            hug += blocked_for<R>(w, nx+dir_dx((Dir)e), ny+dir_dy((Dir)e), p.team);
+        if (cap > best_cap || (cap == best_cap && (hug > best_hug || (hug == best_hug && dd == p.dir)))) {
+            best = dd; best_cap = cap; best_hug = hug;
+        }
+    }
+    p.dir = best;
+}
+
+// ---- obstacle bitboards ----
+
+static inline void bits_set(World& w, int i, bool full) {
+    int x = i % w.GW, y = i / w.GW;
+    uint64_t& rw = w.row_bits[y*w.row_words + (x>>6)];
+    uint64_t& cw = w.col_bits[x*w.col_words + (y>>6)];
+    if (full) { rw |= 1ull << (x&63);    cw |= 1ull << (y&63); }
+    else      { rw &= ~(1ull << (x&63)); cw &= ~(1ull << (y&63)); }
+}
+
+static void bits_build(World& w) {
+    w.row_words = (w.GW + 63) / 64;
+    w.col_words = (w.GH + 63) / 64;
+    w.row_bits.assign(w.GH * w.row_words, 0);
+    w.col_bits.assign(w.GW * w.col_words, 0);
+    for (int i=0; i<w.GW*w.GH; i++)
+        if (w.grid[i] != C_EMPTY) bits_set(w, i, true);
+}
+
+// free cells after / before bit pos in a line; the border walls end every line
+static inline int run_up_line(const uint64_t* line, int pos) {
+    int p = pos + 1, wi = p >> 6;
+    uint64_t m = line[wi] & (~0ull << (p & 63));
+    while (!m) m = line[++wi];
+    return wi*64 + __builtin_ctzll(m) - p;
+}
+static inline int run_down_line(const uint64_t* line, int pos) {
+    int p = pos - 1, wi = p >> 6;
+    uint64_t m = line[wi] & (~0ull >> (63 - (p & 63)));
+    while (!m) m = line[--wi];
+    return p - (wi*64 + 63 - __builtin_clzll(m));
+}
+
+static inline int free_run(const World& w, int x, int y, Dir d) {
+    switch (d) {
+    case D_RIGHT: return run_up_line  (&w.row_bits[y*w.row_words], x);
+    case D_LEFT:  return run_down_line(&w.row_bits[y*w.row_words], x);
+    case D_DOWN:  return run_up_line  (&w.col_bits[x*w.col_words], y);
+    case D_UP:    return run_down_line(&w.col_bits[x*w.col_words], y);
+    default:      return 0;
+    }
+}
+
+// all trail writes go through these two so per-cell derived state stays in sync
+static inline void cell_fill(World& w, int i, Cell c) {
+    Cell& g = w.grid[i];
+    bool was_empty = g == C_EMPTY;
+    blk_adjust(w, i, g, -1); // a teammate may be driving over our trail
+    g = c;
+    blk_adjust(w, i, c, +1);
+    if (w.track_regions && was_empty) region_fill(w, i);
+    if (w.track_bits && was_empty) bits_set(w, i, true);
+    if (w.track_dirty) w.dirty.push_back(i);
+}
+
+static inline void cell_clear(World& w, int i) {
+    Cell& g = w.grid[i];
+    if (g == C_EMPTY) return;
+    blk_adjust(w, i, g, -1);
+    g = C_EMPTY;
+    if (w.track_bits) bits_set(w, i, false);
+    w.prev_dir[i] = D_NONE;
+    w.trail_glyph[i] = TG_NONE;
+    if (w.track_dirty) w.dirty.push_back(i);
+}
+
+static void grid_init(World& w) {
+    int GW = w.GW, GH = w.GH;
+    if (w.map) std::memcpy(w.grid.data(), w.map->cells, GW*GH*sizeof(Cell));
+    else       std::memset(w.grid.data(), C_EMPTY, GW*GH*sizeof(Cell));
+    std::fill(w.prev_dir.begin(), w.prev_dir.end(), D_NONE);
+    std::fill(w.trail_glyph.begin(), w.trail_glyph.end(), (uint8_t)TG_NONE);
+    std::fill(w.ring.begin(), w.ring.end(), 0);
+    for (int x=0;x<GW;x++) { w.grid[w.idx(x,0)]=C_WALL; w.grid[w.idx(x,GH-1)]=C_WALL; }
+    for (int y=0;y<GH;y++) { w.grid[w.idx(0,y)]=C_WALL; w.grid[w.idx(GW-1,y)]=C_WALL; }
+    std::fill(w.blk_count.begin(), w.blk_count.end(), 0);
+    std::fill(w.blk_fill.begin(), w.blk_fill.end(), 0);
+    w.dirty.clear();
+    w.events.clear();
+    w.track_bits = w.num_teams == 0;
+    if (w.track_bits) bits_build(w);
+}
+
+static inline void note(World& w, EventKind k, const Player& p, int by = -1) {
+    if (w.track_events)
+        w.events.push_back({k, (uint8_t)p.dir, (int16_t)p.index, (int16_t)p.x, (int16_t)p.y, (int16_t)by});
+}
+
+// bookkeeping for a bike coming to life / dying: counts, spawn order, and
+// the respawn queue. everything the tick used to rescan the bikes for.
+static void books_live(World& w, Player& p) {
+    int i = p.index;
+    w.alive++;
+    if (w.num_teams && w.team_alive[p.team]++ == 0) w.teams_left++;
+    if (p.slot->human) w.humans_alive++;
+    w.age_prev[i] = (int8_t)w.youngest;
+    w.age_next[i] = -1;
+    if (w.youngest >= 0) w.age_next[w.youngest] = (int8_t)i;
+    else w.oldest = i;
+    w.youngest = i;
+    if (w.leader < 0 || p.trail.size() > w.players[w.leader].trail.size()) w.leader = i;
+}
+
+static void books_dead(World& w, Player& p) {
+    int i = p.index;
+    w.alive--;
+    if (w.num_teams && --w.team_alive[p.team] == 0) w.teams_left--;
+    if (p.slot->human) w.humans_alive--;
+    int a = w.age_prev[i], b = w.age_next[i];
+    if (a >= 0) w.age_next[a] = (int8_t)b; else w.oldest = b;
+    if (b >= 0) w.age_prev[b] = (int8_t)a; else w.youngest = a;
+    if (w.leader != i) return;
+    // ties go to the oldest
+    w.leader = -1;
+    for (int k = w.oldest; k >= 0; k = w.age_next[k])
+        if (w.leader < 0 || w.players[k].trail.size() > w.players[w.leader].trail.size()) w.leader = k;
+}
+
+static void books_clear(World& w) {
+    w.alive = w.teams_left = w.humans = w.humans_alive = 0;
+    std::fill(w.team_alive, w.team_alive + 8, 0);
+    w.oldest = w.youngest = w.leader = -1;
+    w.erase_q.clear();
+    w.respawn_q.clear();
+}
+
+static void on_spawn(World& w, Player& p) {
+    books_live(w, p);
+    note(w, w.tick ? EV_RESPAWN : EV_SPAWN, p);
+}
+
+template<class R>
+static void on_death(World& w, Player& p, int by) {
+    p.death_tick = w.tick;
+    w.regions_changed = true;
+    books_dead(w, p);
+    if (R::respawn(w)) w.erase_q.push(p.index);
+    note(w, EV_DEATH, p, by);
+}
+
+// ---- move scheduler ----
+
+static inline void sched_push(World& w, const Player& p) {
+    w.sched[w.nsched++] = (uint64_t)p.next_move << 6 | p.index;
+    std::push_heap(w.sched, w.sched + w.nsched, std::greater<uint64_t>());
+}
+
+static inline int sched_pop(World& w) {
+    std::pop_heap(w.sched, w.sched + w.nsched, std::greater<uint64_t>());
+    return (int)(w.sched[--w.nsched] & 63);
+}
+
+static inline int64_t sched_next(const World& w) { return (int64_t)(w.sched[0] >> 6); }
+
+// sub-ticks to the move after this one
+static inline int move_period(const World& w, const Player& p) {
+    return boosting(w, p) ? p.period / 2 : p.period;
+}
+
+static void find_spawn(World& w, int &sx, int &sy, Dir &sd) {
+    int GW = w.GW, GH = w.GH;
+    // map spawn table first: a random entry whose start and first step are free
+    if (w.map && w.map->nspawns) {
+        int n = w.map->nspawns, first = w.rng(n);
+        for (int k=0; k<n; k++) {
+            const Arena::Spawn& s = w.map->spawns[(first+k) % n];
+            Dir d = (Dir)s.dir;
+            if (w.grid[w.idx(s.x,s.y)] == C_EMPTY &&
+                w.grid[w.idx(s.x+dir_dx(d), s.y+dir_dy(d))] == C_EMPTY) {
+                sx = s.x; sy = s.y; sd = d;
+                return;
+            }
+        }
+    }
+    for (int attempts=0; attempts<500; attempts++) {
+        sx = 4 + w.rng(GW-8);
+        sy = 4 + w.rng(GH-8);
+        if (w.grid[w.idx(sx,sy)] != C_EMPTY) continue;
+        Dir dirs[] = {D_UP, D_DOWN, D_LEFT, D_RIGHT};
+        for (int d=0; d<4; d++) {
+            int nx = sx+dir_dx(dirs[d]), ny = sy+dir_dy(dirs[d]);
+            if (nx>0 && nx<GW-1 && ny>0 && ny<GH-1 && w.grid[w.idx(nx,ny)]==C_EMPTY) {
+                sd = dirs[d];
+                return;
+            }
+        }
+    }
+    sx = GW/2; sy = GH/2; sd = D_RIGHT;
+}
+
+static void place_head(World& w, Player& p) {
+    p.alive = true; p.active = true;
+    p.death_tick = -1;
+    p.label_tick = -1;
+    p.alone = false;
+    p.alone_tick = p.alone_room = -1;
+    p.boost_left = w.boost_charges;
+    p.boost_end = -1;
+    p.trail.clear();
+    int i = w.idx(p.x, p.y);
+    cell_fill(w, i, p.cell);
+    w.prev_dir[i] = p.dir;
+    w.trail_glyph[i] = TG_HD;
+    p.trail.push(p.x, p.y);
+    if (w.trail_max > 0) w.ring[i]++;
+    p.next_move = (int64_t)(w.tick + 1) * SUB; // first move next tick
+    sched_push(w, p);
+    on_spawn(w, p);
+}
+
+static void spawn_player(World& w, Player& p) {
+    find_spawn(w, p.x, p.y, p.dir);
+    place_head(w, p);
+}
+
+static void spawn_players_fixed(World& w) {
+    struct { float fx, fy; Dir d; } pos[] = {
+        {0.25f, 0.50f, D_RIGHT}, {0.75f, 0.50f, D_LEFT},
+        {0.25f, 0.25f, D_RIGHT}, {0.75f, 0.25f, D_LEFT},
+        {0.25f, 0.75f, D_RIGHT}, {0.75f, 0.75f, D_LEFT},
+        {0.50f, 0.25f, D_DOWN},  {0.50f, 0.75f, D_UP},
+    };
+    int GW = w.GW, GH = w.GH;
+    for (int i=0; i<w.num_players; i++) {
+        Player& p = w.players[i];
+        // a map seats bike i on spawn i; past the end of its table (or on a
+        // repeated entry) find_spawn picks a free one, since the fractions
+        // below know nothing of the map's walls
+        if (w.map) {
+            bool seat = false;
+            if (i < w.map->nspawns) {
+                const Arena::Spawn& s = w.map->spawns[i];
+                Dir d = (Dir)s.dir;
+                seat = w.grid[w.idx(s.x,s.y)] == C_EMPTY &&
+                       w.grid[w.idx(s.x+dir_dx(d), s.y+dir_dy(d))] == C_EMPTY;
+                if (seat) { p.x = s.x; p.y = s.y; p.dir = d; }
+            }
+            if (!seat) find_spawn(w, p.x, p.y, p.dir);
+            place_head(w, p);
+            continue;
+        }
+        p.x = (int)(pos[i].fx * GW);
+        p.y = (int)(pos[i].fy * GH);
+        if (p.x<=1) p.x=2;
+        if (p.x>=GW-2) p.x=GW-3;
+        if (p.y<=1) p.y=2;
+        if (p.y>=GH-2) p.y=GH-3;
+        p.dir = pos[i].d;
+        place_head(w, p);
+    }
+}
+
+static void erase_trail(World& w, Player& p) {
+    bool bounded = w.trail_max > 0;
+    p.trail.each_in(1, 1, w.GW-2, w.GH-2, [&](int cx, int cy) {
+        int i = w.idx(cx,cy);
+        if (!bounded || --w.ring[i] == 0) cell_clear(w, i);
+    });
+    p.trail.clear();
+}
+
+// bounded trails: drop the oldest cell. in team modes the same cell may be
+// further up this trail (it crossed itself) or on a teammate's, so it only
+// clears once no trail holds it any more.
+static void retire_tail(World& w, Player& p) {
+    auto [cx,cy] = p.trail.pop_oldest();
+    if (cx<=0 || cx>=w.GW-1 || cy<=0 || cy>=w.GH-1) return;
+    int i = w.idx(cx,cy);
+    if (--w.ring[i] == 0) cell_clear(w, i);
+}
+
+// free cells from (x,y) in direction d, up to max: a bitboard scan, or a
+// walk in team modes
+template<class R>
+static inline int ray(const World& w, int x, int y, Dir d, int max, int team) {
+    if (!R::teams(w)) return std::min(max, free_run(w, x, y, d));
+    int n = 0;
+    for (; n<max; n++) {
+        x += dir_dx(d); y += dir_dy(d);
+        if (blocked_for<R>(w,x,y,team)) break;
+    }
+    return n;
+}
+
+// ---- shared per-tick head pass ----
+
+static inline int danger_id(const World& w, const Player& p) {
+    return w.num_teams ? p.team : p.index;
+}
+
+// can a head other than p's (or its team's) be in cell i within `steps` ticks?
+static inline bool contested(const World& w, const Player& p, int i, int steps) {
+    const World::Danger& d = w.danger[i];
+    return w.track_danger && d.epoch == w.danger_epoch && d.dist <= steps && d.by != danger_id(w, p);
+}
+
+// every cell head p could drive into in the next `left` ticks (no reversing)
+template<class R>
+static void danger_mark(World& w, const Player& p, int x, int y, Dir from, int dist) {
+    for (int d=0; d<4; d++) {
+        Dir dd = (Dir)d;
+        if (dd == dir_opposite(from)) continue;
+        int nx = x+dir_dx(dd), ny = y+dir_dy(dd);
+        if (blocked_for<R>(w, nx, ny, p.team)) continue;
+        World::Danger& c = w.danger[w.idx(nx,ny)];
+        int id = danger_id(w, p);
+        if (c.epoch != w.danger_epoch || dist < c.dist) c = {w.danger_epoch, (int16_t)id, (uint8_t)dist, 0};
+        else if (dist == c.dist && c.by != id) c.by = -2;
+        if (dist < w.danger_reach) danger_mark<R>(w, p, nx, ny, dd, dist + 1);
+    }
+}
+
+// nearest other live head for every bike (lowest index on a tie, like a
+// scan in index order would pick), each pair measured once. filled on the
+// first think of a tick that wants a target.
+static void build_targets(World& w) {
+    w.targets_epoch = w.head_epoch;
+    long best[MAX_PLAYERS];
+    int n = w.num_players;
+    for (int i=0; i<n; i++) w.target[i] = -1;
+    for (int i=0; i<n; i++) {
+        const Player& p = w.players[i];
+        if (!p.alive || !p.active) continue;
+        for (int j=i+1; j<n; j++) {
+            const Player& o = w.players[j];
+            if (!o.alive || !o.active) continue;
+            long dx = o.x - p.x, dy = o.y - p.y, d = dx*dx + dy*dy;
+            if (w.target[i] < 0 || d < best[i]) { w.target[i] = j; best[i] = d; }
+            if (w.target[j] < 0 || d < best[j]) { w.target[j] = i; best[j] = d; }
+        }
+    }
+}
+
+// nearest other live head, lowest index on a tie. full ai: one all-pairs
+// table a tick serves everyone; level-of-detail ai thinks only a handful
+// of bikes a tick, and a scan each is cheaper than the table.
+static int chase_target(World& w, const Player& p) {
+    if (!w.lod) {
+        if (w.targets_epoch != w.head_epoch) build_targets(w);
+        return w.target[p.index];
+    }
+    int t = -1;
+    long best = 0;
+    for (int j=0; j<w.num_players; j++) {
+        const Player& o = w.players[j];
+        if (j == p.index || !o.alive || !o.active) continue;
+        long dx = o.x - p.x, dy = o.y - p.y, d = dx*dx + dy*dy;
+        if (t < 0 || d < best) { t = j; best = d; }
+    }
+    return t;
+}
+
+// only the bikes moving together can race each other for a cell: anyone
+// due later finds it taken
+template<class R>
+static void build_danger(World& w, const int* due, int nd) {
+    w.danger_epoch++;
+    for (int k=0; k<nd; k++) {
+        const Player& p = w.players[due[k]];
+        if (p.alive && p.active) danger_mark<R>(w, p, p.x, p.y, p.dir, 1);
+    }
+}
+
+template<class R>
+static void ai_think(World& w, Player& p) {
+    if (!p.alive || !p.active || p.slot->human) return;
+    if (p.alone && w.endgame) { endgame_think<R>(w, p); return; }
+    int team = p.team;
+    int look = p.look, inertia = p.inertia, aggression = p.aggression;
+
+    // current direction safe (and nobody about to cut in)?
+    int nx = p.x+dir_dx(p.dir), ny = p.y+dir_dy(p.dir);
+    if (!blocked_for<R>(w,nx,ny,team) && !contested(w, p, w.idx(nx,ny), 1) &&
+        (w.rng(100) < inertia)) return;
+
+    // nearest other alive player
+    int t = chase_target(w, p);
+    int target_x = t >= 0 ? w.players[t].x : -1, target_y = t >= 0 ? w.players[t].y : -1;
+
+    // evaluate each direction
+    Dir best = p.dir;
+    int best_score = -99999;
+    for (int d=0; d<4; d++) {
+        Dir dd = (Dir)d;
+        if (dd == dir_opposite(p.dir)) continue;
+
+        // space check (survival)
+        int space = ray<R>(w, p.x, p.y, dd, look, team);
+        if (p.do_perp && space > 0) {
+            int cx2=p.x+dir_dx(dd), cy2=p.y+dir_dy(dd);
+            for (int sd=0; sd<4; sd++) {
+                Dir perp=(Dir)sd;
+                if (perp==dd||perp==dir_opposite(dd)) continue;
+                space += ray<R>(w, cx2, cy2, perp, look/2, team);
+            }
+        }
+
+        // dead end = never go there
+        if (space == 0) continue;
+
+        // aggression bonus: prefer directions that move toward target
+        int seek_bonus = 0;
+        if (target_x >= 0 && w.rng(100) < aggression) {
+            int step_x = p.x + dir_dx(dd);
+            int step_y = p.y + dir_dy(dd);
+            double old_dist = (p.x-target_x)*(p.x-target_x) + (p.y-target_y)*(p.y-target_y);
+            double new_dist = (step_x-target_x)*(step_x-target_x) + (step_y-target_y)*(step_y-target_y);
+            if (new_dist < old_dist) seek_bonus = 8;
+        }
+
+        int score = space + seek_bonus;
+        // another head gets to a cell on this way first (or as soon): a
+        // head-on race someone loses, so count the way as a fraction of itself
+        for (int s=1, x=p.x, y=p.y; s<=w.danger_reach; s++) {
+            x += dir_dx(dd); y += dir_dy(dd);
+            if (blocked_for<R>(w, x, y, team)) break;
+            if (contested(w, p, w.idx(x,y), s)) { score = score * s / (s + 2); break; }
+        }
+        if (score > best_score) { best_score = score; best = dd; }
+    }
+    p.dir = best;
+
+    // hard ai: a rival head close by and a clear road ahead, burst away
+    if (p.slot->diff == AI_HARD && p.boost_left && t >= 0 && !boosting(w, p)) {
+        int dist = std::abs(target_x - p.x) + std::abs(target_y - p.y);
+        if (dist <= 4 && ray<R>(w, p.x, p.y, best, look, team) == look) Sim::boost(w, p.index);
+    }
+}
+
+// distant bikes: no target search, no side scans. keep going unless it's
+// this bike's turn (staggered by index) or the next cell is blocked, then
+// take the longest straight of the three ways forward.
+template<class R>
+static void cheap_think(World& w, Player& p) {
+    if (!p.alive || !p.active || p.slot->human) return;
+    int nx = p.x+dir_dx(p.dir), ny = p.y+dir_dy(p.dir);
+    bool blocked = blocked_for<R>(w, nx, ny, p.team) || contested(w, p, w.idx(nx,ny), 1);
+    if (!blocked && (w.tick + p.index) % w.lod_every) return;
+    w.cheap_thinks++;
+    if (!blocked && w.rng(100) < p.inertia) return;
+
+    Dir best = p.dir;
+    int best_run = -1;
+    for (int d=0; d<4; d++) {
+        Dir dd = (Dir)d;
+        if (dd == dir_opposite(p.dir)) continue;
+        int run = ray<R>(w, p.x, p.y, dd, p.look, p.team);
+        if (run > best_run || (run == best_run && dd == p.dir)) { best_run = run; best = dd; }
+    }
+    p.dir = best;
+}
+
+// heads bucketed into lod_near-sized squares, so "is anyone near me" looks
+// at 9 buckets instead of every bike
+static void bucket_heads(World& w) {
+    int B = w.lod_near, nbx = w.GW/B + 1, nby = w.GH/B + 1;
+    auto& start = w.bucket_start;
+    auto& items = w.bucket_items;
+    start.assign(nbx*nby + 1, 0);
+    items.resize(w.num_players);
+    for (int i=0; i<w.num_players; i++) {
+        const Player& p = w.players[i];
+        if (p.alive && p.active) start[(p.y/B)*nbx + p.x/B + 1]++;
+    }
+    for (int b=0; b<nbx*nby; b++) start[b+1] += start[b];
+    for (int i=0; i<w.num_players; i++) {
+        const Player& p = w.players[i];
+        if (p.alive && p.active) items[start[(p.y/B)*nbx + p.x/B]++] = i;
+    }
+    for (int b=nbx*nby; b>0; b--) start[b] = start[b-1];
+    start[0] = 0;
+}
+
+static bool near_head(const World& w, const Player& p) {
+    int B = w.lod_near, nbx = w.GW/B + 1, nby = w.GH/B + 1;
+    int bx = p.x/B, by = p.y/B;
+    for (int y=std::max(0,by-1); y<=std::min(nby-1,by+1); y++)
+        for (int x=std::max(0,bx-1); x<=std::min(nbx-1,bx+1); x++) {
+            int b = y*nbx + x;
+            for (int k=w.bucket_start[b]; k<w.bucket_start[b+1]; k++) {
+                const Player& o = w.players[w.bucket_items[k]];
+                if (&o != &p && std::abs(o.x-p.x) <= B && std::abs(o.y-p.y) <= B) return true;
+            }
+        }
+    return false;
+}
+
+static bool in_focus(const World& w, const Player& p) {
+    for (int f=0; f<w.num_focus; f++) {
+        const World::Rect& r = w.focus[f];
+        if (p.x >= r.x0 && p.x < r.x1 && p.y >= r.y0 && p.y < r.y1) return true;
+    }
+    return false;
+}
+
+// the bikes due to move: full thinks for what's on screen first, then for
+// bikes about to tangle, until the tick's budget runs out; everyone else
+// gets cheap_think. only a head within lod_near of another can race it for
+// a cell, so the reach map is built from those alone: the same answers as
+// marking every head, for a fraction of them.
+template<class R>
+static void lod_think(World& w, const int* due, int nd) {
+    bool done[MAX_PLAYERS] = {}, near[MAX_PLAYERS];
+    if (w.track_danger) w.danger_epoch++;
+    for (int k=0; k<nd; k++) {
+        const Player& p = w.players[due[k]];
+        near[k] = p.alive && p.active && near_head(w, p);
+        if (near[k] && w.track_danger) danger_mark<R>(w, p, p.x, p.y, p.dir, 1);
+    }
+    for (int pass=0; pass<2 && w.lod_left>0; pass++)
+        for (int k=0; k<nd && w.lod_left>0; k++) {
+            int i = due[k];
+            Player& p = w.players[i];
+            if (done[i] || !p.alive || !p.active || p.slot->human) continue;
+            if (pass == 0 ? !in_focus(w, p) : !near[k]) continue;
+            ai_think<R>(w, p);
+            done[i] = true;
+            w.lod_left--;
+            w.full_thinks++;
+        }
+    for (int k=0; k<nd; k++)
+        if (!done[due[k]]) cheap_think<R>(w, w.players[due[k]]);
+}
+
+// commit one bike's step into (nx,ny)
+static void move_player(World& w, Player& p, int nx, int ny) {
+    // cache the corner glyph at the old position
+    int oi = w.idx(p.x, p.y);
+    if (w.track_events && p.dir != w.prev_dir[oi]) note(w, EV_TURN, p);
+    if (p.x>0 && p.x<w.GW-1 && p.y>0 && p.y<w.GH-1) {
+        w.trail_glyph[oi] = corner_glyph(w.prev_dir[oi], p.dir);
+        if (w.track_dirty) w.dirty.push_back(oi);
+    }
+
+    p.x = nx; p.y = ny;
+    int ni = w.idx(nx, ny);
+    cell_fill(w, ni, p.cell);
+    w.prev_dir[ni] = p.dir;
+    w.trail_glyph[ni] = TG_HD; // head marker (will be overwritten next move)
+    p.trail.push(nx, ny);
+    if (w.trail_max > 0) {
+        w.ring[ni]++;
+        if (p.trail.size() > w.trail_max) retire_tail(w, p);
+    }
+    if (p.trail.size() > w.players[w.leader].trail.size()) w.leader = p.index;
+}
+
+// simultaneous moves of the bikes due at one sub-tick, so bike order never
+// decides a race. intent: every bike's next cell, checked against the board
+// as it stood before the sub-tick. then bikes claiming the same cell all crash (teammates, who may
+// share cells, excepted), and the rest commit. a swap means each drives
+// into the other's head, which is trail, so the board check kills both.
+template<class R>
+static void move_players(World& w, const int* due, int nd) {
+    int nm = 0;
+    int to[MAX_PLAYERS], by[MAX_PLAYERS], order[MAX_PLAYERS];
+    bool crash[MAX_PLAYERS];
+    for (int k=0;k<nd;k++) {
+        int i = due[k];
+        Player& p = w.players[i];
+        to[i] = -1; by[i] = -1; crash[i] = false;
+        if (!p.alive || !p.active) continue;
+        int nx = p.x + dir_dx(p.dir);
+        int ny = p.y + dir_dy(p.dir);
+        if (!blocked_for<R>(w, nx, ny, p.team)) { to[i] = w.idx(nx, ny); order[nm++] = i; continue; }
+        crash[i] = true;
+        if (w.track_events) {
+            bool inside = nx>0 && nx<w.GW-1 && ny>0 && ny<w.GH-1;
+            Cell c = inside ? w.grid[w.idx(nx,ny)] : C_WALL;
+            if (c >= C_P1) by[i] = (int)c - (int)C_P1;
+        }
+    }
+
+    // same-cell claims: movers sorted by target cell, then each run of two
+    // or more is checked for rivals
+    std::sort(order, order + nm, [&](int a, int b) { return to[a] != to[b] ? to[a] < to[b] : a < b; });
+    for (int k=0, e; k<nm; k=e) {
+        for (e=k+1; e<nm && to[order[e]] == to[order[k]]; e++) {}
+        for (int x=k; x<e; x++)
+            for (int y=k; y<e; y++) {
+                int i = order[x], j = order[y];
+                if (i == j || (R::teams(w) && w.players[i].team == w.players[j].team)) continue;
+                crash[i] = true; by[i] = j;
+                break;
+            }
+    }
+
+    for (int k=0;k<nd;k++) {
+        int i = due[k];
+        Player& p = w.players[i];
+        if (crash[i]) {
+            p.alive = false;
+            on_death<R>(w, p, by[i]);
+        } else if (to[i] >= 0) {
+            move_player(w, p, to[i] % w.GW, to[i] / w.GW);
+            p.next_move += move_period(w, p);
+            sched_push(w, p);
+        }
+    }
+}
+
+template<class R>
+static void check_outcome(World& w) {
+    if (R::endless(w)) {
+        // over once every human is out
+        if (w.humans && !w.humans_alive) w.outcome = HUMANS_OUT;
+        return;
+    }
+    if (R::respawn(w)) return;
+
+    if (R::teams(w)) {
+        if (w.teams_left <= 1) {
+            if (!w.teams_left) { w.outcome = DRAW; return; }
+            w.outcome = TEAM_WIN;
+            int wt = w.players[w.oldest].team;
+            for (int i=0;i<w.num_players;i++)
+                if (w.players[i].team==wt) { w.winner = i; break; }
+        }
+    } else if (w.alive <= 1) {
+        if (w.alive==0) w.outcome = DRAW;
+        else { w.outcome = WINNER; w.winner = w.oldest; }
+    }
+}
+
+// respawning modes: a dead trail flashes (drawn by the front-end), is erased
+// flash_ticks later, and the bike respawns respawn_ticks after dying. both
+// queues are in death order, so only their fronts can be due; bikes due in
+// the same tick go in index order, as a scan would take them.
+template<class R>
+static void respawns(World& w) {
+    auto due = [&](const World::Queue& q, int delay) {
+        return q.n && w.tick - w.players[q.front()].death_tick >= delay ? q.front() : INT_MAX;
+    };
+    for (;;) {
+        int e = due(w.erase_q, w.flash_ticks + 1), r = due(w.respawn_q, w.respawn_ticks);
+        if (e == INT_MAX && r == INT_MAX) break;
+        if (e < r) {
+            Player& p = w.players[e];
+            w.erase_q.pop();
+            erase_trail(w, p);
+            p.active = false;
+            if (!(R::endless(w) && p.slot->human)) w.respawn_q.push(e); // humans stay dead
+        } else {
+            w.respawn_q.pop();
+            spawn_player(w, w.players[r]);
+        }
+    }
+}
+
+// the tick pipeline, instantiated per mode
+template<class R>
+static void step(World& w) {
+    w.tick++;
+    w.head_epoch++; // chase targets: once a tick is close enough
+    w.lod_left = w.lod_budget;
+    if (R::respawn(w) && w.lod) bucket_heads(w); // "near another head" needn't be sub-tick exact
+    // the bikes due this tick, a sub-tick at a time (index order within
+    // one): they think, then move together. bikes not due cost nothing.
+    int64_t end = (int64_t)(w.tick + 1) * SUB;
+    int due[MAX_PLAYERS];
+    while (w.nsched && sched_next(w) < end) {
+        int64_t t = sched_next(w);
+        int nd = 0;
+        while (w.nsched && sched_next(w) == t) due[nd++] = sched_pop(w);
+        if (R::respawn(w) && w.lod) lod_think<R>(w, due, nd);
+        else {
+            if (w.track_danger) build_danger<R>(w, due, nd);
+            for (int k=0;k<nd;k++) ai_think<R>(w, w.players[due[k]]);
+        }
+        move_players<R>(w, due, nd);
+    }
+    if (R::respawn(w)) respawns<R>(w);
+
+    if (w.track_regions && w.regions_changed) update_sealed(w);
+    check_outcome<R>(w);
+    if (w.sealed && w.settle_sealed && w.outcome == ONGOING) settle(w);
+}
+
+static void (*kernel_for(GameMode m))(World&) {
+    switch (m) {
+        case MODE_1V1:     return step<Rules<MODE_1V1>>;
+        case MODE_FFA:     return step<Rules<MODE_FFA>>;
+        case MODE_2V2:     return step<Rules<MODE_2V2>>;
+        case MODE_ENDLESS: return step<Rules<MODE_ENDLESS>>;
+        case MODE_AUTO:    return step<Rules<MODE_AUTO>>;
+        case MODE_3V3:     return step<Rules<MODE_3V3>>;
+        case MODE_4X2:     return step<Rules<MODE_4X2>>;
+        case MODE_2X4:     return step<Rules<MODE_2X4>>;
+    }
+    return step<Dynamic>;
+}
+
+void Sim::create(World& w, GameMode mode, int gw, int gh, int tick_ms, int trail_max) {
+    w.mode = mode;
+    w.GW = gw; w.GH = gh;
+    w.grid.assign(gw*gh, C_EMPTY);
+    w.prev_dir.assign(gw*gh, D_NONE);
+    w.trail_glyph.assign(gw*gh, TG_NONE);
+    w.region_mark.assign(gw*gh, 0);
+    w.region_epoch = 0;
+    w.danger.assign(gw*gh, {0, 0, 0, 0});
+    w.danger_epoch = 0;
+    w.trail_max = trail_max;
+    w.ring.assign(trail_max > 0 ? gw*gh : 0, 0);
+    w.blk_w = w.blk_h = 0;
+    w.blk_count.clear(); w.blk_fill.clear();
+
+    // passability per team: empty yes, walls no, trails only of your own team
+    w.num_teams = mode_teams(mode);
+    w.pass.assign(w.num_teams << 8, 0);
+    for (int t=0; t<w.num_teams; t++) {
+        w.pass[t<<8 | C_EMPTY] = 1;
+        for (int i=0; i<mode_players(mode); i++)
+            if (mode_team_of(mode, i) == t) w.pass[t<<8 | (C_P1+i)] = 1;
+    }
+
+    w.flash_ticks   = 2000 / tick_ms;
+    w.respawn_ticks = (mode==MODE_AUTO ? 3000 : 10000) / tick_ms;
+    if (w.flash_ticks < 2) w.flash_ticks = 2;
+    if (w.respawn_ticks < w.flash_ticks + 2) w.respawn_ticks = w.flash_ticks + 2;
+    w.boost_ticks = std::max(2, 1000 / tick_ms); // a second of double speed
+}
+
+void Sim::enable_blocks(World& w, int bw, int bh) {
+    w.blk_bw = bw; w.blk_bh = bh;
+    w.blk_w = (w.GW + bw - 1) / bw;
+    w.blk_h = (w.GH + bh - 1) / bh;
+    w.blk_count.assign(w.blk_w*w.blk_h*PC_COUNT, 0);
+    w.blk_fill.assign(w.blk_w*w.blk_h, 0);
+    // count what's already down (a spectator turns these on mid-round)
+    for (int i=0; i<w.GW*w.GH; i++) blk_adjust(w, i, w.grid[i], +1);
+}
+
+// round setup shared by start_round and snapshot restores: fresh arena,
+// players bound to their slots, nobody on the board yet
+static void seat_players(World& w, Slot* slots, int nslots) {
+    w.tick = 0;
+    w.outcome = ONGOING;
+    w.winner = -1;
+    w.step = w.generic ? step<Dynamic> : kernel_for(w.mode);
+    w.track_regions = false; // labelled in one go once everyone is placed
+    w.sealed = false;
+    w.sealed_tick = -1;
+    w.nsched = 0;
+    books_clear(w);
+    grid_init(w);
+
+    bool respawning = w.mode == MODE_ENDLESS || w.mode == MODE_AUTO;
+    w.num_players = respawning ? std::clamp(nslots, 1, MAX_PLAYERS) : mode_players(w.mode);
+    for (int i=0; i<w.num_players; i++) {
+        Player& p = w.players[i];
+        p.slot = &slots[i];
+        p.cell = (Cell)(C_P1+i);
+        p.index = i;
+        p.team = mode_team_of(w.mode, i);
+        if (w.mode == MODE_AUTO) {
+            p.look = 20; p.inertia = 30; p.aggression = 40;
+        } else {
+            AIDiff d = slots[i].diff;
+            p.look       = (d==AI_EASY) ? 2  : (d==AI_MED) ? 5  : 12;
+            p.inertia    = (d==AI_EASY) ? 85 : (d==AI_MED) ? 70 : 50;
+            p.aggression = (d==AI_EASY) ? 5  : (d==AI_MED) ? 15 : 30;
+        }
+        p.do_perp = (slots[i].diff == AI_HARD || w.mode == MODE_AUTO);
+        // mixed speeds: every third cpu bike at 2/3, every third at 1/2. with
+        // boosts too, every move lands on a half tick.
+        static const int mixed[3] = {SUB, SUB*3/2, SUB*2};
+        p.period = (w.mixed_speeds && respawning && !slots[i].human) ? mixed[i % 3] : SUB;
+        p.boost_left = 0;
+        p.boost_end = -1;
+        p.alive = p.active = false;
+        p.alone = false;
+        p.alone_tick = p.alone_room = -1;
+        p.trail.clear();
+        if (slots[i].human) w.humans++;
+    }
+}
+
+// respawns and retracting tails reopen space, so regions only pay off
+// when trails are for keeps
+static void start_regions(World& w) {
+    bool respawning = w.mode == MODE_ENDLESS || w.mode == MODE_AUTO;
+    if (!respawning && w.trail_max == 0) {
+        region_label_all(w);
+        w.track_regions = true;
+        w.regions_changed = true;
+    }
+}
+
+void Sim::start_round(World& w, Slot* slots, int nslots, uint32_t seed) {
+    w.rng.seed(seed);
+    seat_players(w, slots, nslots);
+    if (w.mode == MODE_ENDLESS || w.mode == MODE_AUTO) {
+        for (int i=0; i<w.num_players; i++) spawn_player(w, w.players[i]);
+    } else {
+        spawn_players_fixed(w);
+    }
+    start_regions(w);
+}
+
+void Sim::restore_begin(World& w, Slot* slots, int nslots) {
+    seat_players(w, slots, nslots);
+}
+
+void Sim::restore_end(World& w) {
+    int n = w.GW * w.GH;
+    std::fill(w.blk_count.begin(), w.blk_count.end(), 0);
+    std::fill(w.blk_fill.begin(), w.blk_fill.end(), 0);
+    for (int i=0; i<n; i++) {
+        Cell c = w.grid[i];
+        if (c < C_P1) continue;
+        blk_adjust(w, i, c, +1);
+        if (w.track_dirty) w.dirty.push_back(i);
+    }
+    if (w.track_bits) bits_build(w);
+    start_regions(w);
+    // the snapshot's trail_max may differ from create()'s
+    w.ring.assign(w.trail_max > 0 ? n : 0, 0);
+    if (w.trail_max > 0)
+        for (int k=0; k<w.num_players; k++)
+            w.players[k].trail.each_in(1, 1, w.GW-2, w.GH-2, [&](int cx, int cy) { w.ring[w.idx(cx,cy)]++; });
+
+    // bookkeeping from the restored bikes: the live ones by trail length
+    // (spawn order), the dead by death tick
+    bool respawning = w.mode == MODE_ENDLESS || w.mode == MODE_AUTO;
+    int order[MAX_PLAYERS], nb = w.num_players;
+    for (int i=0; i<nb; i++) order[i] = i;
+    auto key = [&](int i) {
+        const Player& p = w.players[i];
+        return std::make_pair(p.alive ? -p.trail.size() : p.death_tick, i);
+    };
+    std::sort(order, order + nb, [&](int a, int b) { return key(a) < key(b); });
+    for (int k=0; k<nb; k++) {
+        Player& p = w.players[order[k]];
+        if (p.alive) { books_live(w, p); sched_push(w, p); }
+        else if (!respawning || p.death_tick < 0) continue;
+        else if (p.active) w.erase_q.push(p.index);
+        else if (!(w.mode == MODE_ENDLESS && p.slot->human)) w.respawn_q.push(p.index);
+    }
+}
+
+bool Sim::boost(World& w, int i) {
+    Player& p = w.players[i];
+    if (!p.alive || p.boost_left <= 0 || boosting(w, p)) return false;
+    p.boost_left--;
+    p.boost_end = w.tick + w.boost_ticks;
+    return true;
+}
+
+int Sim::longest_trail(const World& w) {
+    if (w.leader >= 0) return w.leader;
+    if (w.respawn_q.n) return w.respawn_q.front();
+    if (w.erase_q.n) return w.erase_q.front();
+    return -1;
+}
+
+int Sim::area_leader(World& w) {
+    update_sealed(w);
+    int best = -1, best_reach = -1;
+    bool tie = false;
+    for (int i=0; i<w.num_players; i++) {
+        if (w.num_teams && best >= 0 && w.players[i].team == w.players[best].team) continue;
+        if (w.reach[i] > best_reach) { best = i; best_reach = w.reach[i]; tie = false; }
+        else if (w.reach[i] == best_reach) tie = true;
+    }
+    return tie ? -1 : best;
+}
+
+void Sim::settle(World& w) {
+    int lead = area_leader(w);
+    if (lead < 0) { w.outcome = DRAW; return; }
+    w.outcome = w.num_teams ? TEAM_WIN : WINNER;
+    w.winner = lead;
+}
@@ -0,0 +1,328 @@
+#pragma once
+#include "types.h"
+#include "arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// the simulation: arena, bikes, ai, respawns, win checks. no ncurses in here;
+// game.cpp feeds it input and draws from it, bench.cpp runs it headless.
+
+// glyph indices matching Trail:: constants
+enum TGlyph : uint8_t {
+    TG_NONE=0, TG_V, TG_H, TG_UL, TG_UR, TG_DL, TG_DR, TG_HD
+};
+
+// a trail as a polyline, oldest segment first: each segment is a start cell
+// and a straight run, so a trail costs 8 bytes per turn instead of per cell.
+// with bounded trails the ring stops growing once it holds a trail's worth
+// of turns, so retiring the tail every tick never allocates.
+struct TrailSeg {
+    int16_t  x, y;  // first cell
+    uint16_t len;   // cells, >= 1
+    uint8_t  dir, pad;
+    int end_x() const { return x + dir_dx((Dir)dir) * (len-1); }
+    int end_y() const { return y + dir_dy((Dir)dir) * (len-1); }
+};
+
+struct TrailLine {
+    std::vector<TrailSeg> buf;
+    int head = 0, nseg = 0; // head = slot of the oldest segment
+    int count = 0;          // cells
+
+    int size() const { return count; }
+    int segments() const { return nseg; }
+    void clear() { head = nseg = count = 0; }
+    const TrailSeg& seg(int i) const { return buf[(head+i) % (int)buf.size()]; }
+    TrailSeg& seg(int i) { return buf[(head+i) % (int)buf.size()]; }
+
+    // append the cell next to the newest one (or the first cell). a segment
+    // runs the way it was entered; only a lone first cell has no way yet.
+    void push(int x, int y) {
+        count++;
+        Dir d = D_RIGHT;
+        if (nseg) {
+            TrailSeg& s = seg(nseg-1);
+            int dx = x - s.end_x(), dy = y - s.end_y();
+            d = dx ? (dx > 0 ? D_RIGHT : D_LEFT) : (dy > 0 ? D_DOWN : D_UP);
+            if (nseg == 1 && s.len == 1) s.dir = d;
+            if (s.dir == d && s.len < UINT16_MAX) { s.len++; return; }
+        }
+        if (nseg == (int)buf.size()) {
+            std::vector<TrailSeg> nb(buf.empty() ? 16 : buf.size()*2);
+            for (int i=0; i<nseg; i++) nb[i] = seg(i);
+            buf.swap(nb); head = 0;
+        }
+        buf[(head+nseg) % (int)buf.size()] = {(int16_t)x, (int16_t)y, 1, (uint8_t)d, 0};
+        nseg++;
+    }
+    std::pair<int,int> pop_oldest() {
+        TrailSeg& s = buf[head];
+        std::pair<int,int> c{s.x, s.y};
+        count--;
+        if (--s.len == 0) { head = (head+1) % (int)buf.size(); nseg--; }
+        else { s.x += dir_dx((Dir)s.dir); s.y += dir_dy((Dir)s.dir); }
+        return c;
+    }
+
+    // every cell, oldest first
+    template<class F> void each(F f) const {
+        for (int i=0; i<nseg; i++) {
+            const TrailSeg& s = seg(i);
+            int dx = dir_dx((Dir)s.dir), dy = dir_dy((Dir)s.dir);
+            for (int k=0; k<s.len; k++) f(s.x + dx*k, s.y + dy*k);
+        }
+    }
+    // only the cells inside [x0,x1] x [y0,y1]: segments whose box misses the
+    // rect cost one test, the rest are clipped to it
+    template<class F> void each_in(int x0, int y0, int x1, int y1, F f) const {
+        for (int i=0; i<nseg; i++) {
+            const TrailSeg& s = seg(i);
+            int ex = s.end_x(), ey = s.end_y();
+            if (std::max<int>(s.x, ex) < x0 || std::min<int>(s.x, ex) > x1 ||
+                std::max<int>(s.y, ey) < y0 || std::min<int>(s.y, ey) > y1)
+                continue;
+            int dx = dir_dx((Dir)s.dir), dy = dir_dy((Dir)s.dir);
+            // steps k along the run that stay inside the rect
+            int lo = 0, hi = s.len - 1;
+            if (dx > 0) { lo = std::max(lo, x0 - s.x); hi = std::min(hi, x1 - s.x); }
+            if (dx < 0) { lo = std::max(lo, s.x - x1); hi = std::min(hi, s.x - x0); }
+            if (dy > 0) { lo = std::max(lo, y0 - s.y); hi = std::min(hi, y1 - s.y); }
+            if (dy < 0) { lo = std::max(lo, s.y - y1); hi = std::min(hi, s.y - y0); }
+            for (int k=lo; k<=hi; k++) f(s.x + dx*k, s.y + dy*k);
+        }
+    }
+};
+
+struct Player {
+    int x, y;
+    Dir dir;
+    bool alive;
+    bool active;
+    Slot* slot;
+    Cell cell;
+    int index;
+    int team;
+    int death_tick;
+    int label_tick;
+    TrailLine trail;
+    // ai tuning, resolved once per round from mode + difficulty
+    int look, inertia, aggression;
+    bool do_perp;
+    // walled into space nobody else can reach (region tracking): since when,
+    // and how many cells it had then
+    bool alone;
+    int alone_tick, alone_room;
+    // speed: sub-ticks per cell (Sim::SUB = a cell a tick) and the sub-tick
+    // the next move is due. a boost burst halves the period up to boost_end.
+    int period;
+    int64_t next_move;
+    int boost_left, boost_end;
+};
+
+namespace Sim {
+    // bikes per world. fixed modes seat mode_players(); Endless/AutoTron can
+    // be given a bigger crowd.
+    constexpr int MAX_PLAYERS = 64;
+    // sub-ticks per tick: moves are timed (and collide) at this resolution
+    constexpr int SUB = 12;
+
+    // xorshift64*, kept per world so a round replays from its seed
+    struct Rng {
+        uint64_t s = 1;
+        void seed(uint32_t v) {
+            uint64_t z = v + 0x9e3779b97f4a7c15ull; // splitmix64 scramble
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            s = (z ^ (z >> 31)) | 1;
+        }
+        uint32_t next() {
+            s ^= s >> 12; s ^= s << 25; s ^= s >> 27;
+            return (uint32_t)((s * 0x2545f4914f6cdd1dull) >> 32);
+        }
+        int operator()(int n) { return (int)(next() % (uint32_t)n); }
+    };
+
+    enum Outcome { ONGOING=0, WINNER, TEAM_WIN, DRAW, HUMANS_OUT };
+
+    // what happened to a bike this tick, for the front-end to pass on
+    enum EventKind : uint8_t { EV_SPAWN=0, EV_TURN, EV_DEATH, EV_RESPAWN };
+    struct Event {
+        EventKind kind;
+        uint8_t dir;     // Dir after the event
+        int16_t player;
+        int16_t x, y;
+        int16_t by;      // EV_DEATH: owner of the cell hit, -1 = wall
+    };
+
+    struct World {
+        GameMode mode = MODE_1V1;
+        int GW = 0, GH = 0;
+        std::vector<Cell>    grid;
+        std::vector<Dir>     prev_dir;
+        std::vector<uint8_t> trail_glyph; // cached glyph index per cell
+        const Arena::Map* map = nullptr;  // walls + spawn table, null = open box
+
+        // obstacle bitboards, one bit per cell (set = not empty), by row and
+        // by column. a fill or clear flips two bits; the free run from a cell
+        // in any direction is a find-first-set over a word or two, so ai
+        // look-ahead costs the same at any distance. off in team modes, where
+        // what counts as free depends on who is asking.
+        bool track_bits = false;
+        int  row_words = 0, col_words = 0;
+        std::vector<uint64_t> row_bits; // [y*row_words + x/64]
+        std::vector<uint64_t> col_bits; // [x*col_words + y/64]
+
+        Player players[MAX_PLAYERS];
+        int num_players = 0;
+        int trail_max = 0;     // 0 = unlimited, else cells kept per trail
+        // bounded trails: [cell] how many trail entries hold it. a team trail
+        // may cross itself or a teammate's, and the cell clears with its last copy
+        std::vector<uint16_t> ring;
+        int flash_ticks = 2;   // dead trail stays (flashing) this long
+        int respawn_ticks = 4; // ticks from death to respawn
+        int tick = 0;          // last tick simulated
+        // move scheduler: live bikes in a min-heap keyed next_move*64 + index,
+        // so a tick only touches the bikes due in it, a sub-tick at a time
+        uint64_t sched[MAX_PLAYERS];
+        int nsched = 0;
+        int boost_charges = 3; // bursts per life
+        int boost_ticks = 18;  // length of a burst
+        bool mixed_speeds = false; // respawning modes: cpu bikes at 1, 2/3 or 1/2 speed
+        int num_teams = 0;     // 0 = no teams
+        std::vector<uint8_t> pass; // [team<<8 | cell]: 1 = that team may drive through
+        Rng rng;
+
+        Outcome outcome = ONGOING;
+        int winner = -1; // player index (first of the team for TEAM_WIN)
+
+        // round bookkeeping, kept up to date by the sim's own spawn and death
+        // events rather than rescanned every tick
+        int alive = 0, teams_left = 0, humans = 0, humans_alive = 0;
+        int team_alive[8];
+        // live bikes, oldest spawn first
+        int oldest = -1, youngest = -1;
+        int8_t age_prev[MAX_PLAYERS], age_next[MAX_PLAYERS];
+        // the live bike with the longest trail: taken over by whoever grows
+        // past it, found again from the age list when it dies
+        int leader = -1;
+        // respawning modes: the dead in death order, first waiting for their
+        // trail to be erased, then to respawn. the delays are fixed, so due
+        // bikes are always at the front.
+        struct Queue {
+            int8_t q[MAX_PLAYERS];
+            int head = 0, n = 0;
+            void clear() { head = n = 0; }
+            int front() const { return q[head]; }
+            void push(int i) { q[(head+n++) % MAX_PLAYERS] = (int8_t)i; }
+            void pop() { head = (head+1) % MAX_PLAYERS; n--; }
+        };
+        Queue erase_q, respawn_q;
+
+        // optional per-block, per-color trail counts (minimap); blk_w = 0 = off
+        int blk_w = 0, blk_h = 0, blk_bw = 1, blk_bh = 1;
+        std::vector<uint32_t> blk_count; // [block*PC_COUNT + color]
+        std::vector<uint32_t> blk_fill;  // trail cells per block
+
+        // optional list of cells whose grid/glyph changed since the front-end
+        // last cleared it
+        bool track_dirty = false;
+        std::vector<int> dirty;
+
+        // optional list of spawns, turns, deaths and respawns since the
+        // front-end last cleared it (start_round clears it too)
+        bool track_events = false;
+        std::vector<Event> events;
+
+        // level-of-detail ai (respawning modes). full ai_think goes to bikes
+        // inside a focus rect (what the cameras show) or near another head, at
+        // most lod_budget a tick; the rest steer cheaply every lod_every ticks,
+        // staggered, or as soon as their next cell is blocked.
+        struct Rect { int x0, y0, x1, y1; };
+        bool lod = false;
+        Rect focus[2];
+        int  num_focus   = 0;
+        int  lod_near    = 12;
+        int  lod_budget  = 16;
+        int  lod_every   = 4;
+        int  lod_left    = 0; // full thinks left this tick
+        long full_thinks = 0, cheap_thinks = 0; // running totals
+        std::vector<int> bucket_start, bucket_items; // head spatial hash, rebuilt per tick
+
+        // empty-space regions, for fixed modes with unbounded trails (space
+        // only ever shrinks there). region[] labels every empty cell, -1 for
+        // the rest; a fill relabels only when it may have cut a region in two.
+        // sealed = no region is reachable by two live bikes (teams), so the
+        // round comes down to who fills their own pocket best.
+        bool track_regions = false;
+        bool settle_sealed = false; // end a sealed round on reachable area (bench, tronsim)
+        bool sealed = false;
+        int  sealed_tick = -1;
+        int  reach[MAX_PLAYERS];    // empty cells each bike (its team) can still reach
+        bool regions_changed = false;
+        std::vector<int> region, region_size, region_odd, region_owner; // odd = cells with x+y odd
+        std::vector<uint32_t> region_mark; // flood scratch, stamped per split
+        uint32_t region_epoch = 0;
+        std::vector<int> flood_q[4];
+        // bikes left alone switch to a space-filling endgame; its cut checks
+        // walk at most endgame_budget cells per candidate step
+        bool endgame = true;
+        long endgame_budget = 2048;
+
+        // shared per-tick head pass, instead of every ai redoing it:
+        // head reach, rebuilt before each sub-tick's movers think: for each
+        // cell one of their heads can drive into within danger_reach moves,
+        // how soon, and whose head (its team in team modes; -2 = more than
+        // one got there first). ai_think backs off cells another head reaches
+        // no later than it would, instead of racing it there head-on.
+        struct Danger { uint32_t epoch; int16_t by; uint8_t dist, pad; };
+        bool track_danger = true;
+        int  danger_reach = 1;
+        uint32_t danger_epoch = 0;
+        std::vector<Danger> danger;
+        // and each bike's chase target (nearest other live head, -1 = none),
+        // worked out for everyone at once the first time a tick needs one
+        uint32_t head_epoch = 0, targets_epoch = 0; // current while equal
+        int8_t   target[MAX_PLAYERS];
+
+        // bench baseline: run the kernel with the mode checks left in
+        bool generic = false;
+        void (*step)(World&) = nullptr;
+
+        int idx(int x, int y) const { return y*GW + x; }
+    };
+
+    void create(World& w, GameMode mode, int gw, int gh, int tick_ms, int trail_max);
+    // turn on the per-block counters, blocks of bw x bh cells
+    void enable_blocks(World& w, int bw, int bh);
+    // fresh arena, everyone spawned from the slots. picks the tick kernel.
+    // nslots is mode_players() except for crowds in respawning modes.
+    void start_round(World& w, Slot* slots, int nslots, uint32_t seed);
+    // snapshots: restore_begin resets the arena and seats the slots like
+    // start_round but spawns nobody; the caller then writes grid cells, player
+    // state, tick and rng, and restore_end rebuilds what derives from them
+    void restore_begin(World& w, Slot* slots, int nslots);
+    void restore_end(World& w);
+    // one tick: ai, moves, deaths, respawns, win check
+    inline void tick(World& w) { w.step(w); }
+    // start a boost burst for bike i: false if it's dead, already boosting
+    // or out of charges
+    bool boost(World& w, int i);
+    inline bool boosting(const World& w, const Player& p) { return p.boost_end >= w.tick; }
+
+    int cell_color(const World& w, Cell c); // slot color of a player trail cell
+    // worlds replayed from another process (spectators): set cell i and its
+    // glyph, keeping the block counts in step
+    void paint(World& w, int i, Cell c, uint8_t glyph);
+
+    // the live bike with the longest trail, else the dead one that died
+    // first (respawns soonest), else -1
+    int longest_trail(const World& w);
+
+    // sealed rounds: refresh reach[] and return the bike (first of the team)
+    // with the most room, -1 on a tie
+    int area_leader(World& w);
+    // end a sealed round now: the area leader wins, a tie is a draw
+    void settle(World& w);
+}
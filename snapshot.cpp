@@ -0,0 +1,284 @@
+#include "snapshot.h"
+#include "config.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+constexpr uint32_t SNAP_MAGIC   = 0x534e5254; // "TRNS"
+constexpr uint32_t SNAP_VERSION = 2;
+constexpr int      CHUNK        = 16;
+constexpr int      SIDE_MAX     = 4096;
+constexpr int      STEP_MAX     = 0x3fff; // run length bits in a step
+
+struct Header {
+    uint32_t magic, version;
+    uint8_t  mode, use_camera, arena_kind, pad;
+    uint16_t gw, gh, nplayers, map_len;
+    int32_t  tick, trail_max, flash_ticks, respawn_ticks;
+    uint64_t rng;
+    uint32_t seed, nchunks;
+    double   elapsed;
+};
+
+struct SlotRec {
+    uint8_t human, color, keyset, diff, team, pad[3];
+};
+
+struct PlayerRec {
+    int16_t  x, y;
+    uint8_t  dir, alive, active, age; // age: place in spawn order, 255 = not alive
+    int32_t  death_tick, label_tick;
+    uint16_t trail_x, trail_y; // oldest trail cell
+    uint32_t nsteps;
+    int16_t  period, boost_left;
+    int32_t  boost_end;
+    int64_t  next_move; // sub-tick the scheduler moves it at
+};
+
+struct CellRun {
+    uint8_t count, cell, glyph, dir;
+};
+
+// what grid_init puts in cell i before anyone drives
+Cell base_cell(const Sim::World& w, int i) {
+    int x = i % w.GW, y = i / w.GW;
+    if (x == 0 || y == 0 || x == w.GW-1 || y == w.GH-1) return C_WALL;
+    return w.map ? w.map->cells[i] : C_EMPTY;
+}
+
+int chunk_cells(const Sim::World& w, int chunk, int* out) {
+    int cw = (w.GW + CHUNK-1) / CHUNK;
+    int x0 = (chunk % cw) * CHUNK, y0 = (chunk / cw) * CHUNK, n = 0;
+    for (int y=y0; y<std::min(y0+CHUNK, w.GH); y++)
+        for (int x=x0; x<std::min(x0+CHUNK, w.GW); x++) out[n++] = y*w.GW + x;
+    return n;
+}
+
+// bounds-checked reader over the whole file
+struct Reader {
+    std::vector<char> buf;
+    size_t at = 0;
+    bool get(void* dst, size_t n) {
+        if (at + n > buf.size()) return false;
+        std::memcpy(dst, buf.data() + at, n);
+        at += n;
+        return true;
+    }
+};
+
+bool slurp(const std::string& path, Reader& r) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char tmp[65536];
+    size_t n;
+    while ((n = fread(tmp, 1, sizeof(tmp), f)) > 0) r.buf.insert(r.buf.end(), tmp, tmp + n);
+    fclose(f);
+    return true;
+}
+
+bool read_head(Reader& r, Header& h, Snapshot::Meta& m) {
+    if (!r.get(&h, sizeof(h))) return false;
+    if (h.magic != SNAP_MAGIC || h.version != SNAP_VERSION || h.mode >= MODE_COUNT ||
+        h.gw < 16 || h.gh < 12 || h.gw > SIDE_MAX || h.gh > SIDE_MAX ||
+        h.nplayers < 1 || h.nplayers > Sim::MAX_PLAYERS)
+        return false;
+    m.mode = (GameMode)h.mode;
+    m.gw = h.gw; m.gh = h.gh;
+    m.use_camera = h.use_camera;
+    m.arena_kind = h.arena_kind;
+    m.seed = h.seed;
+    m.elapsed = h.elapsed;
+    m.slots.resize(h.nplayers);
+    for (Slot& s : m.slots) {
+        SlotRec sr;
+        if (!r.get(&sr, sizeof(sr))) return false;
+        if (sr.color >= PC_COUNT || sr.keyset >= keysets().size() || sr.diff > AI_HARD) return false;
+        s = {sr.human != 0, (PColor)sr.color, sr.keyset, (AIDiff)sr.diff, sr.team};
+    }
+    m.map_file.resize(h.map_len);
+    return r.get(&m.map_file[0], h.map_len);
+}
+}
+
+std::string Snapshot::path() { return Config::dir() + "/suspend"; }
+
+bool Snapshot::save(const std::string& path, const Sim::World& w, const Meta& m) {
+    std::vector<char> out;
+    auto put = [&](const void* p, size_t n) { out.insert(out.end(), (const char*)p, (const char*)p + n); };
+
+    Header h{};
+    h.magic = SNAP_MAGIC; h.version = SNAP_VERSION;
+    h.mode = (uint8_t)w.mode; h.use_camera = m.use_camera; h.arena_kind = (uint8_t)m.arena_kind;
+    h.gw = w.GW; h.gh = w.GH; h.nplayers = w.num_players;
+    h.map_len = (uint16_t)m.map_file.size();
+    h.tick = w.tick; h.trail_max = w.trail_max;
+    h.flash_ticks = w.flash_ticks; h.respawn_ticks = w.respawn_ticks;
+    h.rng = w.rng.s; h.seed = m.seed; h.elapsed = m.elapsed;
+    put(&h, sizeof(h)); // nchunks patched in below
+    for (int i=0; i<w.num_players; i++) {
+        const Slot& s = *w.players[i].slot;
+        SlotRec sr{(uint8_t)s.human, (uint8_t)s.color, (uint8_t)s.keyset, (uint8_t)s.diff, (uint8_t)s.team, {}};
+        put(&sr, sizeof(sr));
+    }
+    put(m.map_file.data(), m.map_file.size());
+
+    // spawn order: trail length stops telling it once bikes move at different speeds
+    uint8_t age[Sim::MAX_PLAYERS];
+    std::fill(age, age + Sim::MAX_PLAYERS, 255);
+    for (int i = w.oldest, k = 0; i >= 0; i = w.age_next[i]) age[i] = (uint8_t)k++;
+
+    // trails: where they start, then the polyline's straight runs
+    std::vector<uint16_t> steps;
+    for (int i=0; i<w.num_players; i++) {
+        const Player& p = w.players[i];
+        const TrailLine& t = p.trail;
+        steps.clear();
+        for (int k=0; k<t.segments(); k++) {
+            const TrailSeg& sg = t.seg(k);
+            uint16_t d = (uint16_t)sg.dir << 14;
+            for (int n = sg.len - (k == 0); n > 0; ) { // the first cell is the start
+                int run = std::min(n, STEP_MAX);
+                steps.push_back(d | run);
+                n -= run;
+            }
+        }
+        PlayerRec pr{(int16_t)p.x, (int16_t)p.y, (uint8_t)p.dir, p.alive, p.active, age[i],
+                     p.death_tick, p.label_tick,
+                     (uint16_t)(t.size() ? t.seg(0).x : 0), (uint16_t)(t.size() ? t.seg(0).y : 0),
+                     (uint32_t)steps.size(),
+                     (int16_t)p.period, (int16_t)p.boost_left, p.boost_end, p.next_move};
+        if (!t.size()) pr.nsteps = UINT32_MAX; // no trail at all (waiting to respawn)
+        put(&pr, sizeof(pr));
+        put(steps.data(), steps.size() * sizeof(uint16_t));
+    }
+
+    // grid: only chunks that differ from the bare arena
+    int nchunks = ((w.GW + CHUNK-1) / CHUNK) * ((w.GH + CHUNK-1) / CHUNK), cells[CHUNK*CHUNK];
+    std::vector<CellRun> runs;
+    for (int c=0; c<nchunks; c++) {
+        int n = chunk_cells(w, c, cells);
+        bool same = true;
+        for (int k=0; k<n && same; k++) {
+            int i = cells[k];
+            same = w.grid[i] == base_cell(w, i) && w.trail_glyph[i] == TG_NONE && w.prev_dir[i] == D_NONE;
+        }
+        if (same) continue;
+        runs.clear();
+        for (int k=0; k<n; k++) {
+            int i = cells[k];
+            CellRun cr{1, w.grid[i], w.trail_glyph[i], (uint8_t)w.prev_dir[i]};
+            CellRun* b = runs.empty() ? nullptr : &runs.back();
+            if (b && b->count < 255 && b->cell == cr.cell && b->glyph == cr.glyph && b->dir == cr.dir) b->count++;
+            else runs.push_back(cr);
+        }
+        uint32_t idx = c;
+        uint16_t nr = (uint16_t)runs.size();
+        put(&idx, sizeof(idx));
+        put(&nr, sizeof(nr));
+        put(runs.data(), runs.size() * sizeof(CellRun));
+        h.nchunks++;
+    }
+    std::memcpy(out.data(), &h, sizeof(h));
+
+    // write aside and rename, so a crash mid-write keeps the previous snapshot
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) { remove(tmp.c_str()); return false; }
+    return true;
+}
+
+bool Snapshot::peek(const std::string& path, Meta& m) {
+    Reader r;
+    Header h;
+    return slurp(path, r) && read_head(r, h, m);
+}
+
+bool Snapshot::load(const std::string& path, Sim::World& w, Slot* slots) {
+    Reader r;
+    Header h;
+    Meta m;
+    if (!slurp(path, r) || !read_head(r, h, m)) return false;
+    if (h.mode != w.mode || h.gw != w.GW || h.gh != w.GH) return false;
+
+    Sim::restore_begin(w, slots, h.nplayers);
+    if (w.num_players != h.nplayers) return false;
+    w.tick = h.tick;
+    w.trail_max = h.trail_max;
+    w.flash_ticks = h.flash_ticks;
+    w.respawn_ticks = h.respawn_ticks;
+    w.rng.s = h.rng;
+
+    auto inside = [&](int x, int y) { return x > 0 && y > 0 && x < w.GW-1 && y < w.GH-1; };
+    int by_age[Sim::MAX_PLAYERS], nage = 0;
+    std::fill(by_age, by_age + Sim::MAX_PLAYERS, -1);
+    for (int i=0; i<w.num_players; i++) {
+        Player& p = w.players[i];
+        PlayerRec pr;
+        if (!r.get(&pr, sizeof(pr)) || pr.dir > D_NONE) return false;
+        p.x = pr.x; p.y = pr.y; p.dir = (Dir)pr.dir;
+        p.alive = pr.alive; p.active = pr.active;
+        p.death_tick = pr.death_tick; p.label_tick = pr.label_tick;
+        if (pr.alive != (pr.age != 255) || (pr.alive && (pr.age >= w.num_players || by_age[pr.age] >= 0)))
+            return false;
+        if (pr.alive) { by_age[pr.age] = i; nage++; }
+        // a boost halves the period, so 1 would book the next move on the
+        // same sub-tick forever; a live bike's move is due after the saved tick
+        if (pr.period < 2 || pr.period > 4*Sim::SUB || pr.next_move < 0) return false;
+        if (pr.alive && pr.next_move < (int64_t)(h.tick + 1) * Sim::SUB) return false;
+        p.period = pr.period; p.boost_left = pr.boost_left;
+        p.boost_end = pr.boost_end; p.next_move = pr.next_move;
+        if (pr.nsteps == UINT32_MAX) continue;
+        int x = pr.trail_x, y = pr.trail_y;
+        if (!inside(x, y)) return false;
+        p.trail.push(x, y);
+        for (uint32_t k=0; k<pr.nsteps; k++) {
+            uint16_t s;
+            if (!r.get(&s, sizeof(s))) return false;
+            Dir d = (Dir)(s >> 14);
+            for (int n = s & STEP_MAX; n > 0; n--) {
+                x += dir_dx(d); y += dir_dy(d);
+                if (!inside(x, y)) return false;
+                p.trail.push(x, y);
+            }
+        }
+    }
+
+    int nchunks = ((w.GW + CHUNK-1) / CHUNK) * ((w.GH + CHUNK-1) / CHUNK), cells[CHUNK*CHUNK];
+    for (uint32_t c=0; c<h.nchunks; c++) {
+        uint32_t idx;
+        uint16_t nr;
+        if (!r.get(&idx, sizeof(idx)) || !r.get(&nr, sizeof(nr)) || idx >= (uint32_t)nchunks) return false;
+        int n = chunk_cells(w, idx, cells), k = 0;
+        for (int j=0; j<nr; j++) {
+            CellRun cr;
+            if (!r.get(&cr, sizeof(cr)) || k + cr.count > n || cr.glyph > TG_HD || cr.dir > D_NONE ||
+                (cr.cell >= C_P1 && cr.cell - C_P1 >= w.num_players))
+                return false;
+            for (int e=0; e<cr.count; e++, k++) {
+                w.grid[cells[k]] = (Cell)cr.cell;
+                w.trail_glyph[cells[k]] = cr.glyph;
+                w.prev_dir[cells[k]] = (Dir)cr.dir;
+            }
+        }
+        if (k != n) return false;
+    }
+    if (r.at != r.buf.size()) return false;
+    for (int k=0; k<nage; k++) if (by_age[k] < 0) return false;
+    Sim::restore_end(w);
+
+    // restore_end guesses spawn order from trail length; put back the real one
+    w.oldest = w.youngest = -1;
+    for (int k=0; k<nage; k++) {
+        int i = by_age[k];
+        w.age_prev[i] = (int8_t)w.youngest;
+        w.age_next[i] = -1;
+        if (w.youngest >= 0) w.age_next[w.youngest] = (int8_t)i;
+        else w.oldest = i;
+        w.youngest = i;
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "types.h"
+#include "sim.h"
+#include <string>
+#include <vector>
+
+// suspended matches. a snapshot is the World minus what can be derived:
+// cells that differ from the bare arena, in 16x16 chunks (run-length coded,
+// chunks that match the arena are left out), plus each bike's trail as a
+// start cell and run-length coded steps, tick counters and rng state.
+//
+// file format (native endian):
+//   Header
+//   SlotRec   slots[nplayers]
+//   char      map_file[map_len]
+//   per player: PlayerRec, uint16 steps[nsteps]   (dir<<14 | run length)
+//   per chunk:  uint32 chunk, uint16 nruns, CellRun runs[nruns]
+namespace Snapshot {
+    // what the front-end needs besides the World to carry on
+    struct Meta {
+        GameMode mode = MODE_ENDLESS;
+        int gw = 0, gh = 0;
+        bool use_camera = false;
+        int arena_kind = 0;       // Arena::Kind the arena was generated with
+        uint32_t seed = 0;        // round seed: history, and regenerates the arena
+        std::string map_file;     // --map the round was on, "" = none
+        double elapsed = 0;       // seconds played before the suspend
+        std::vector<Slot> slots;  // every bike's slot, crowd included
+    };
+
+    std::string path(); // ~/.config/tron/suspend
+
+    bool save(const std::string& path, const Sim::World& w, const Meta& m);
+    // header, slots and map name only
+    bool peek(const std::string& path, Meta& m);
+    // into a world Sim::create'd for m's mode and size, with its map set.
+    // slots must outlive the world (players point into them).
+    bool load(const std::string& path, Sim::World& w, Slot* slots);
+}
@@ -0,0 +1,269 @@
+#include "spectate.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint32_t SHM_MAGIC   = 0x57525454; // "TTRW"
+constexpr uint32_t SHM_VERSION = 1;
+constexpr uint64_t RING        = 1 << 15;   // deltas
+
+struct Head {
+    int16_t x, y;
+    uint8_t dir, alive, active, color, human, pad[3];
+};
+
+struct Delta {
+    uint32_t idx;
+    uint16_t key; // cell<<8 | glyph
+    uint16_t pad;
+};
+
+// the segment: this header, then uint16 cells[gw*gh] (cell<<8 | glyph),
+// then Delta ring[RING]. the size only ever grows, so a watcher still
+// mapped at the old size never faults.
+struct Shared {
+    uint32_t magic, version;
+    uint64_t bytes;
+    int32_t  pid;
+    std::atomic<uint32_t> seq; // odd while the game is writing
+    // under seq from here on
+    uint32_t round;            // bumps when the whole grid is rewritten
+    uint8_t  mode, nplayers, closed, pad;
+    uint16_t gw, gh;
+    int32_t  tick_ms, tick;
+    int16_t  follow, pad2;
+    uint64_t deltas;           // written so far
+    Head     heads[Sim::MAX_PLAYERS];
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "seqlock needs a lock-free counter");
+
+std::string shm_name() { return "/tron-" + std::to_string(getuid()); }
+
+uint16_t* cells_of(Shared* s) { return (uint16_t*)(s + 1); }
+Delta*   ring_of(Shared* s) { return (Delta*)(cells_of(s) + (size_t)s->gw * s->gh); }
+uint64_t bytes_for(int gw, int gh) { return sizeof(Shared) + (uint64_t)gw*gh*sizeof(uint16_t) + RING*sizeof(Delta); }
+
+// --- publisher ---
+int     pub_fd = -1;
+Shared* pub = nullptr;
+size_t  pub_len = 0;
+
+void write_begin() {
+    pub->seq.store(pub->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+void write_end() {
+    pub->seq.store(pub->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void write_heads(const Sim::World& w, int follow) {
+    pub->nplayers = (uint8_t)w.num_players;
+    pub->tick = w.tick;
+    pub->follow = (int16_t)follow;
+    for (int i=0; i<w.num_players; i++) {
+        const Player& p = w.players[i];
+        pub->heads[i] = {(int16_t)p.x, (int16_t)p.y, (uint8_t)p.dir, p.alive, p.active,
+                         (uint8_t)p.slot->color, p.slot->human, {}};
+    }
+}
+
+// --- watcher ---
+int     sub_fd = -1;
+Shared* sub = nullptr;
+size_t  sub_len = 0;
+uint32_t sub_round = 0;
+uint64_t sub_deltas = 0;
+bool     sub_synced = false;
+std::vector<uint16_t> sub_cells;
+std::vector<Delta>    sub_ring;
+
+bool sub_map() {
+    struct stat st;
+    if (fstat(sub_fd, &st) != 0 || (size_t)st.st_size < sizeof(Shared)) return false;
+    if (sub) munmap(sub, sub_len);
+    sub_len = st.st_size;
+    void* p = mmap(nullptr, sub_len, PROT_READ, MAP_SHARED, sub_fd, 0);
+    sub = p == MAP_FAILED ? nullptr : (Shared*)p;
+    return sub && sub->magic == SHM_MAGIC && sub->version == SHM_VERSION;
+}
+}
+
+bool Spectate::open() {
+    std::string name = shm_name();
+    for (int tries=0; tries<2; tries++) {
+        pub_fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (pub_fd >= 0) break;
+        if (errno != EEXIST) return false;
+        // left behind by a game that died without cleaning up?
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) continue;
+        Shared s{};
+        bool live = pread(fd, &s, sizeof(s), 0) == (ssize_t)sizeof(s) && s.pid > 0 &&
+                    s.pid != getpid() && kill(s.pid, 0) == 0 && !s.closed;
+        ::close(fd);
+        if (live) return false;
+        shm_unlink(name.c_str());
+    }
+    if (pub_fd < 0) return false;
+    pub_len = bytes_for(16, 12);
+    if (ftruncate(pub_fd, pub_len) != 0) { close(); return false; }
+    void* p = mmap(nullptr, pub_len, PROT_READ | PROT_WRITE, MAP_SHARED, pub_fd, 0);
+    if (p == MAP_FAILED) { close(); return false; }
+    pub = (Shared*)p;
+    pub->magic = SHM_MAGIC;
+    pub->version = SHM_VERSION;
+    pub->bytes = pub_len;
+    pub->pid = getpid();
+    return true;
+}
+
+bool Spectate::publishing() { return pub != nullptr; }
+
+void Spectate::round(const Sim::World& w, int follow, int tick_ms) {
+    if (!pub) return;
+    uint64_t need = bytes_for(w.GW, w.GH);
+    if (need > pub_len) {
+        // grow first, then move the mapping; watchers remap when bytes grows.
+        // if that fails, stop publishing: tick() would write the bigger
+        // world's cells past the end of the old mapping
+        void* p = MAP_FAILED;
+        if (ftruncate(pub_fd, need) == 0)
+            p = mmap(nullptr, need, PROT_READ | PROT_WRITE, MAP_SHARED, pub_fd, 0);
+        if (p == MAP_FAILED) { close(); return; }
+        munmap(pub, pub_len);
+        pub = (Shared*)p;
+        pub_len = need;
+        pub->bytes = need;
+    }
+    write_begin();
+    pub->round++;
+    pub->mode = (uint8_t)w.mode;
+    pub->gw = w.GW; pub->gh = w.GH;
+    pub->tick_ms = tick_ms;
+    uint16_t* cells = cells_of(pub);
+    for (int i=0; i<w.GW*w.GH; i++) cells[i] = (uint16_t)(w.grid[i] << 8 | w.trail_glyph[i]);
+    write_heads(w, follow);
+    write_end();
+}
+
+void Spectate::tick(const Sim::World& w, int follow) {
+    if (!pub) return;
+    write_begin();
+    uint16_t* cells = cells_of(pub);
+    Delta* ring = ring_of(pub);
+    for (int i : w.dirty) {
+        uint16_t key = (uint16_t)(w.grid[i] << 8 | w.trail_glyph[i]);
+        cells[i] = key;
+        ring[pub->deltas++ % RING] = {(uint32_t)i, key, 0};
+    }
+    write_heads(w, follow);
+    write_end();
+}
+
+void Spectate::close() {
+    if (pub) {
+        write_begin();
+        pub->closed = 1;
+        write_end();
+        munmap(pub, pub_len);
+        pub = nullptr;
+    }
+    if (pub_fd >= 0) {
+        ::close(pub_fd);
+        pub_fd = -1;
+        shm_unlink(shm_name().c_str());
+    }
+}
+
+bool Spectate::attach() {
+    detach();
+    sub_fd = shm_open(shm_name().c_str(), O_RDONLY, 0);
+    if (sub_fd < 0) return false;
+    if (!sub_map()) { detach(); return false; }
+    sub_synced = false;
+    return true;
+}
+
+void Spectate::detach() {
+    if (sub) munmap(sub, sub_len);
+    if (sub_fd >= 0) ::close(sub_fd);
+    sub = nullptr; sub_fd = -1;
+}
+
+Spectate::Sync Spectate::sync(Sim::World& w, Slot* slots, int& follow, int& tick_ms) {
+    if (!sub) return GONE;
+    if (sub->bytes > sub_len && !sub_map()) return GONE;
+
+    // copy out under the seqlock; if the game wrote meanwhile, copy again
+    Shared hdr;
+    bool full = false, copied = false;
+    for (int tries=0; tries<1000 && !copied; tries++) {
+        uint32_t s1 = sub->seq.load(std::memory_order_acquire);
+        if (s1 & 1) { sched_yield(); continue; }
+        std::memcpy((void*)&hdr, (const void*)sub, sizeof(Shared));
+        size_t n = (size_t)hdr.gw * hdr.gh;
+        if (hdr.closed || sizeof(Shared) + n*sizeof(uint16_t) + RING*sizeof(Delta) > sub_len)
+            return GONE;
+        full = !sub_synced || hdr.round != sub_round || hdr.deltas - sub_deltas > RING;
+        if (full) {
+            sub_cells.resize(n);
+            std::memcpy(sub_cells.data(), cells_of(sub), n * sizeof(uint16_t));
+        } else {
+            const Delta* ring = (const Delta*)(cells_of(sub) + n);
+            sub_ring.clear();
+            for (uint64_t d = sub_deltas; d < hdr.deltas; d++) sub_ring.push_back(ring[d % RING]);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        copied = sub->seq.load(std::memory_order_relaxed) == s1;
+    }
+    if (!copied) return NOTHING; // the game kept us out; try again next frame
+    if (hdr.pid <= 0 || kill(hdr.pid, 0) != 0) return GONE;
+    if (hdr.mode >= MODE_COUNT || hdr.nplayers > Sim::MAX_PLAYERS || hdr.gw < 3 || hdr.gh < 3) return GONE;
+
+    // the heads first: painting a trail cell looks up its bike's color
+    bool changed = full || hdr.deltas != sub_deltas || hdr.tick != w.tick;
+    if (full && (w.mode != hdr.mode || w.GW != hdr.gw || w.GH != hdr.gh || !sub_synced))
+        Sim::create(w, (GameMode)hdr.mode, hdr.gw, hdr.gh, hdr.tick_ms, 0);
+    w.num_players = hdr.nplayers;
+    w.tick = hdr.tick;
+    for (int i=0; i<hdr.nplayers; i++) {
+        const Head& h = hdr.heads[i];
+        Player& p = w.players[i];
+        slots[i].color = (PColor)(h.color % PC_COUNT);
+        slots[i].human = h.human;
+        p.slot = &slots[i];
+        p.cell = (Cell)(C_P1 + i);
+        p.index = i;
+        p.x = std::clamp<int>(h.x, 0, hdr.gw-1);
+        p.y = std::clamp<int>(h.y, 0, hdr.gh-1);
+        p.dir = (Dir)(h.dir % 5);
+        p.alive = h.alive; p.active = h.active;
+    }
+    auto paint = [&](int i, uint16_t key) {
+        Cell c = (Cell)(key >> 8);
+        if (c >= C_P1 && c - C_P1 >= hdr.nplayers) c = C_EMPTY; // torn or stale: drop it
+        Sim::paint(w, i, c, (uint8_t)(key & 0xff));
+    };
+    if (full) {
+        for (size_t i=0; i<sub_cells.size(); i++) paint((int)i, sub_cells[i]);
+    } else {
+        for (const Delta& d : sub_ring)
+            if (d.idx < (uint32_t)(w.GW*w.GH)) paint((int)d.idx, d.key);
+    }
+    sub_synced = true;
+    sub_round = hdr.round;
+    sub_deltas = hdr.deltas;
+    follow = hdr.follow >= 0 && hdr.follow < hdr.nplayers ? hdr.follow : 0;
+    tick_ms = hdr.tick_ms > 0 ? hdr.tick_ms : 50;
+    return full ? NEW_ROUND : changed ? TICKED : NOTHING;
+}
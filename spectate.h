@@ -0,0 +1,27 @@
+#pragma once
+#include "types.h"
+#include "sim.h"
+
+// --publish: the game mirrors its world into a POSIX shared-memory segment
+// (/tron-<uid>) and ./tron watch renders it from another terminal. the game
+// never waits on a watcher: each tick it bumps a seqlock, copies the cells
+// that changed into the mirror and a delta ring, writes the heads, and bumps
+// it again. watchers copy out under the seqlock and retry if it moved; one
+// that fell more than a ring behind re-reads the whole mirror.
+namespace Spectate {
+    // publisher. open() fails if another live game is already publishing.
+    bool open();
+    bool publishing();
+    void round(const Sim::World& w, int follow, int tick_ms); // whole grid
+    void tick(const Sim::World& w, int follow);               // w.dirty + heads
+    void close();
+
+    // watcher
+    enum Sync { NOTHING=0, TICKED, NEW_ROUND, GONE };
+    bool attach();
+    // bring w up to date, painting with Sim::paint. NEW_ROUND: w was rebuilt
+    // (maybe at another size or mode), so whatever was drawn from it is stale.
+    // slots[MAX_PLAYERS] back w's players; follow = the game's own camera target
+    Sync sync(Sim::World& w, Slot* slots, int& follow, int& tick_ms);
+    void detach();
+}
@@ -0,0 +1,154 @@
+#include "tronsim.h"
+#include "sim.h"
+#include "arena.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// the C ABI over Sim: one World per handle, seated from a config the way
+// game.cpp seats it from the menu
+
+static_assert(TRONSIM_SUB == Sim::SUB, "tronsim.h sub-tick out of step with sim.h");
+
+// the smallest size a caller's struct may declare: everything up to the
+// last field abi 2 had. fields added later are read only if size covers them
+constexpr size_t CONFIG_V2 = offsetof(tronsim_config, mixed_speeds) + sizeof(int);
+constexpr size_t VIEW_V2   = offsetof(tronsim_view, bike_stride) + sizeof(int);
+
+static tronsim_config defaults() {
+    tronsim_config c{};
+    c.size = sizeof c;
+    c.mode = MODE_1V1;
+    c.width = 120; c.height = 40;
+    c.bikes = 8;
+    c.trail_max = 0;
+    c.tick_ms = 55;
+    c.difficulty = AI_MED;
+    c.arena = Arena::OPEN;
+    c.map_file = nullptr;
+    c.external = 0;
+    c.mixed_speeds = 0;
+    c.settle_sealed = 0;
+    return c;
+}
+
+struct tronsim {
+    Sim::World world;
+    Arena::Map arena;
+    Arena::Kind gen = Arena::OPEN;
+    bool map_file = false;
+    Slot slots[Sim::MAX_PLAYERS];
+    int nslots = 0;
+    tronsim_bike bikes[Sim::MAX_PLAYERS];
+};
+
+extern "C" {
+
+int tronsim_abi(void) { return TRONSIM_ABI; }
+
+void tronsim_defaults(tronsim_config* c) {
+    if (!c || c->size <= sizeof c->size) return;
+    tronsim_config d = defaults();
+    memcpy((char*)c + sizeof c->size, (const char*)&d + sizeof d.size,
+           std::min<size_t>(c->size, sizeof d) - sizeof d.size);
+}
+
+tronsim* tronsim_create(const tronsim_config* caller) {
+    if (!caller || caller->size < CONFIG_V2) return nullptr;
+    // an older caller's struct stops short: the rest keeps its default
+    tronsim_config cfg = defaults();
+    memcpy(&cfg, caller, std::min<size_t>(caller->size, sizeof cfg));
+    const tronsim_config* c = &cfg;
+    if (c->mode < 0 || c->mode >= MODE_COUNT) return nullptr;
+    if (c->difficulty < AI_EASY || c->difficulty > AI_HARD) return nullptr;
+    if (c->arena < 0 || c->arena >= Arena::KIND_COUNT || c->tick_ms <= 0 || c->trail_max < 0)
+        return nullptr;
+    GameMode mode = (GameMode)c->mode;
+    bool respawning = mode == MODE_ENDLESS || mode == MODE_AUTO;
+    if (respawning && (c->bikes < 1 || c->bikes > Sim::MAX_PLAYERS)) return nullptr;
+
+    tronsim* s = new tronsim;
+    int gw = c->width, gh = c->height;
+    if (c->map_file) {
+        if (!Arena::load(s->arena, c->map_file)) { delete s; return nullptr; }
+        s->map_file = true;
+        gw = s->arena.w; gh = s->arena.h;
+    }
+    if (gw < 16 || gh < 16 || gw > INT16_MAX || gh > INT16_MAX) { delete s; return nullptr; }
+    s->gen = (Arena::Kind)c->arena;
+
+    s->nslots = respawning ? c->bikes : mode_players(mode);
+    for (int i=0; i<s->nslots; i++) {
+        Slot& sl = s->slots[i];
+        sl.human = (c->external >> i) & 1;
+        sl.color = (PColor)(i % PC_COUNT);
+        sl.diff  = (AIDiff)c->difficulty;
+        sl.team  = respawning ? 0 : mode_team_of(mode, i);
+    }
+
+    Sim::create(s->world, mode, gw, gh, c->tick_ms, c->trail_max);
+    s->world.mixed_speeds = c->mixed_speeds != 0;
+    s->world.settle_sealed = c->settle_sealed != 0;
+    s->world.map = (s->map_file || s->gen != Arena::OPEN) ? &s->arena : nullptr;
+    tronsim_start(s, 1);
+    return s;
+}
+
+void tronsim_destroy(tronsim* s) {
+    delete s;
+}
+
+void tronsim_start(tronsim* s, uint32_t seed) {
+    Sim::World& w = s->world;
+    if (!s->map_file && s->gen != Arena::OPEN) Arena::generate(s->arena, s->gen, w.GW, w.GH, seed);
+    Sim::start_round(w, s->slots, s->nslots, seed);
+}
+
+int tronsim_steer(tronsim* s, int bike, int dir) {
+    Sim::World& w = s->world;
+    if (bike < 0 || bike >= w.num_players || dir < D_UP || dir > D_RIGHT) return 0;
+    Player& p = w.players[bike];
+    if (!p.slot->human || !p.alive) return 0;
+    // against the way the head came in, so two turns in one tick can't reverse
+    if ((Dir)dir == dir_opposite(w.prev_dir[w.idx(p.x, p.y)])) return 0;
+    p.dir = (Dir)dir;
+    return 1;
+}
+
+int tronsim_boost(tronsim* s, int bike) {
+    Sim::World& w = s->world;
+    if (bike < 0 || bike >= w.num_players || !w.players[bike].slot->human) return 0;
+    return Sim::boost(w, bike);
+}
+
+int tronsim_step(tronsim* s, int n) {
+    Sim::World& w = s->world;
+    for (int k=0; k<n && w.outcome == Sim::ONGOING; k++) Sim::tick(w);
+    return w.outcome;
+}
+
+void tronsim_observe(tronsim* s, tronsim_view* out) {
+    if (!out || out->size < VIEW_V2) return;
+    const Sim::World& w = s->world;
+    for (int i=0; i<w.num_players; i++) {
+        const Player& p = w.players[i];
+        s->bikes[i] = {(int16_t)p.x, (int16_t)p.y, (uint8_t)p.dir, p.alive, p.active,
+                       (uint8_t)p.team, p.trail.size(), p.death_tick,
+                       (int16_t)p.period, (uint8_t)p.boost_left, Sim::boosting(w, p)};
+    }
+    tronsim_view v{};
+    v.size   = out->size;
+    v.width  = w.GW;
+    v.height = w.GH;
+    v.cells  = reinterpret_cast<const uint8_t*>(w.grid.data());
+    v.glyphs = w.trail_glyph.data();
+    v.tick    = w.tick;
+    v.outcome = w.outcome;
+    v.winner  = w.winner;
+    v.nbikes  = w.num_players;
+    v.bikes   = s->bikes;
+    v.bike_stride = sizeof(tronsim_bike);
+    memcpy(out, &v, std::min<size_t>(out->size, sizeof v));
+}
+
+}
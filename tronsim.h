@@ -0,0 +1,114 @@
+#pragma once
+#include <stdint.h>
+
+// libtronsim: the simulation behind ./tron, for driving in-process from C or
+// anything with a C FFI (make lib builds libtronsim.a and libtronsim.so).
+// no ncurses, no files under ~/.config, no threads.
+//
+//   tronsim_config c = {sizeof c};
+//   tronsim_defaults(&c);
+//   c.mode = 1; c.external = 1;            // FFA, bike 0 steered by us
+//   tronsim* s = tronsim_create(&c);
+//   tronsim_start(s, 42);
+//   tronsim_view v = {sizeof v};
+//   while (tronsim_step(s, 1) == TRONSIM_ONGOING) {
+//       tronsim_observe(s, &v);            // v.cells is the live grid
+//       tronsim_steer(s, 0, pick(&v));     // tronsim_bike_at(&v, i) per bike
+//   }
+//   tronsim_destroy(s);
+//
+// the ABI only grows: new fields go at the end of the structs and
+// TRONSIM_ABI goes up when they do. a client built against an older header
+// keeps working with a newer library:
+// - config and view start with size, the caller's sizeof. the library reads
+//   and writes only that much; fields past it take their defaults
+// - bikes are bike_stride bytes apart, not sizeof(tronsim_bike)
+// a change that can't be made this way gets a new soname (now libtronsim.so.2).
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRONSIM_ABI 3
+#define TRONSIM_API __attribute__((visibility("default")))
+
+typedef struct tronsim tronsim;
+
+// cells: bike i's trail (head included) is TRONSIM_BIKE + i
+enum { TRONSIM_EMPTY = 0, TRONSIM_WALL = 1, TRONSIM_BIKE = 2 };
+enum { TRONSIM_UP = 0, TRONSIM_DOWN, TRONSIM_LEFT, TRONSIM_RIGHT, TRONSIM_NONE };
+enum { TRONSIM_SUB = 12 };
+enum { TRONSIM_ONGOING = 0, TRONSIM_WINNER, TRONSIM_TEAM_WIN, TRONSIM_DRAW, TRONSIM_HUMANS_OUT };
+
+typedef struct {
+    uint32_t size;     // sizeof(tronsim_config), set by the caller
+    int mode;          // game mode number, as settings and history store it
+    int width, height; // world size, walls included; a map file overrides it
+    int bikes;         // Endless/AutoTron crowd, 1..64; fixed modes seat their own
+    int trail_max;     // cells kept per trail, 0 = unlimited
+    int tick_ms;       // game speed the flash and respawn delays are timed for
+    int difficulty;    // built-in ai: 0 easy, 1 medium, 2 hard
+    int arena;         // 0 open, 1 maze, 2 pillars, 3 rooms (new layout per round)
+    const char* map_file; // arena from a ./tron mapgen file instead, NULL = none
+    uint64_t external; // bit i: bike i is steered through tronsim_steer, not the ai.
+                       // such bikes count as humans (Endless ends when they're out)
+    int mixed_speeds;  // Endless/AutoTron: ai bikes at 1, 2/3 or 1/2 speed
+    int settle_sealed; // fixed modes, unlimited trails: once every bike is walled
+                       // into its own pocket, end the round there and give it to
+                       // the most room (abi 3)
+} tronsim_config;
+
+typedef struct {
+    int16_t x, y;
+    uint8_t dir;
+    uint8_t alive;     // on the board and moving
+    uint8_t active;    // has a trail on the board (dead trails linger a while)
+    uint8_t team;
+    int32_t trail;     // trail length in cells
+    int32_t death_tick; // -1 while alive
+    int16_t period;    // sub-ticks per move, TRONSIM_SUB = one cell a tick
+    uint8_t boost_left; // boosts left this life
+    uint8_t boosting;
+} tronsim_bike;
+
+typedef struct {
+    uint32_t size;         // sizeof(tronsim_view), set by the caller
+    int width, height;
+    const uint8_t* cells;  // width*height, row-major: the sim's own grid
+    const uint8_t* glyphs; // same layout: 0 none, 1 │, 2 ─, 3 ╭, 4 ╮, 5 ╰, 6 ╯, 7 head
+    int tick;
+    int outcome;
+    int winner;            // bike index (first of the team for TEAM_WIN), -1 = none
+    int nbikes;
+    const tronsim_bike* bikes; // read through tronsim_bike_at
+    int bike_stride;           // bytes from one bike to the next
+} tronsim_view;
+
+static inline const tronsim_bike* tronsim_bike_at(const tronsim_view* v, int i) {
+    return (const tronsim_bike*)((const char*)v->bikes + (long)i * v->bike_stride);
+}
+
+TRONSIM_API int tronsim_abi(void);
+// fills in the first c->size bytes of c; size itself is left alone
+TRONSIM_API void tronsim_defaults(tronsim_config* c);
+// NULL if the config is out of range (or its size too small for abi 2) or
+// the map file won't load
+TRONSIM_API tronsim* tronsim_create(const tronsim_config* c);
+TRONSIM_API void tronsim_destroy(tronsim* s);
+// a fresh round; the same seed replays the same round
+TRONSIM_API void tronsim_start(tronsim* s, uint32_t seed);
+// turn an external bike for the next tick. reversing (or a bad bike or dir)
+// is ignored: returns 0 then, else 1
+TRONSIM_API int tronsim_steer(tronsim* s, int bike, int dir);
+// double speed for about a second, a few times a life: returns 0 if the
+// bike isn't external and alive or has none left, else 1
+TRONSIM_API int tronsim_boost(tronsim* s, int bike);
+// up to n ticks, stopping early when the round is decided; returns the outcome
+TRONSIM_API int tronsim_step(tronsim* s, int n);
+// zero-copy: cells and glyphs point into the sim and stay valid (and current)
+// until tronsim_destroy; bikes is refreshed by each call. writes the first
+// v->size bytes of v, or nothing if that's too small for abi 2
+TRONSIM_API void tronsim_observe(tronsim* s, tronsim_view* v);
+
+#ifdef __cplusplus
+}
+#endif
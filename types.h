@@ -37,16 +37,16 @@ constexpr int CP_DIM   = 21;
 constexpr int CP_FLASH = 22;
 
 struct KeySet {
-    int up, down, left, right;
+    int up, down, left, right, boost;
     const char* name;
 };
 
 inline const std::vector<KeySet>& keysets() {
     static const std::vector<KeySet> k = {
-        {'w','s','a','d',                          "WASD"},
-        {'i','k','j','l',                          "IJKL"},
-        {KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT,    "Arrows"},
-        {'8','5','4','6',                          "Numpad"},
+        {'w','s','a','d','e',                        "WASD"},
+        {'i','k','j','l','o',                        "IJKL"},
+        {KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT,'\n', "Arrows"},
+        {'8','5','4','6','0',                        "Numpad"},
     };
     return k;
 }
@@ -54,18 +54,40 @@ inline const std::vector<KeySet>& keysets() {
 enum AIDiff { AI_EASY=0, AI_MED, AI_HARD };
 constexpr const char* diff_name[] = {"Easy","Medium","Hard"};
 
-enum GameMode { MODE_1V1=0, MODE_FFA, MODE_2V2, MODE_ENDLESS, MODE_AUTO };
-constexpr const char* mode_name[] = {"1v1","FFA (4p)","2v2 Teams","Endless","AutoTron"};
-inline int mode_players(GameMode m) {
+// new modes go at the end: the number is what settings and history store
+enum GameMode { MODE_1V1=0, MODE_FFA, MODE_2V2, MODE_ENDLESS, MODE_AUTO,
+                MODE_3V3, MODE_4X2, MODE_2X4 };
+constexpr int MODE_COUNT = MODE_2X4 + 1;
+constexpr const char* mode_name[] = {"1v1","FFA (4p)","2v2 Teams","Endless","AutoTron",
+                                     "3v3 Teams","4x2 Teams","2x4 Teams"};
+constexpr int mode_players(GameMode m) {
     switch(m) {
         case MODE_1V1: return 2;
         case MODE_FFA: return 4;
         case MODE_2V2: return 4;
         case MODE_ENDLESS: return 8;
         case MODE_AUTO: return 6;
+        case MODE_3V3: return 6;
+        case MODE_4X2: return 8;
+        case MODE_2X4: return 8;
     }
     return 2;
 }
+// number of teams, 0 = every player for themselves
+constexpr int mode_teams(GameMode m) {
+    switch(m) {
+        case MODE_2V2: return 2;
+        case MODE_3V3: return 2;
+        case MODE_4X2: return 4;
+        case MODE_2X4: return 2;
+        default: return 0;
+    }
+}
+// team of player i: consecutive slots fill a team
+constexpr int mode_team_of(GameMode m, int i) {
+    int t = mode_teams(m);
+    return t ? i / (mode_players(m) / t) : 0;
+}
 
 struct Slot {
     bool human    = false;